@@ -0,0 +1,399 @@
+#ifdef _WIN32
+#   define _CRT_SECURE_NO_WARNINGS        // silence MSVC CRT warnings
+#endif
+
+// mem_crash_bench — the fixed scenario catalogue, built optimised
+// (-O2 + LTO) so the numbers it prints are the ones worth publishing.
+//
+// Every run writes its metrics as JSON.  With --baseline they are checked
+// against a stored run and its per-metric tolerances, and the exit status
+// says whether anything got worse than allowed.  A baseline recorded on
+// another host (different config hash) is only advisory unless
+// --strict-host is given.
+
+#include "crash_guard.h"
+#include "heap_overflow.h"
+#include "host_info.h"
+#include "kernel_access.h"
+#include "malloc_corrupt.h"
+#include "replay.h"
+#include "stats.h"
+#include "kaizen.h"
+
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#  include <windows.h>
+#else
+#  include <unistd.h>
+#endif
+
+struct Opt {
+    std::string out = "mem_crash_bench.json";
+    std::string baseline;           // compare against this ("" = don't)
+    std::string write_baseline;     // store this run as a baseline ("" = don't)
+    int         trials      = 200;  // per latency scenario
+    bool        strict_host = false;
+};
+
+static Opt parse(int argc, char** argv)
+{
+    zen::cmd_args a(argv, argc);
+    Opt o;
+    if (a.is_present("--help") || a.is_present("-h")) {
+        std::cout << "Usage: " << argv[0] << " [--out FILE.json] [--baseline FILE.json] "
+                  << "[--write-baseline FILE.json] [--trials N] [--strict-host]\n"
+                  << "Exit status: 0 = within tolerance, 1 = regression, 2 = error\n";
+        std::exit(0);
+    }
+    try {
+        o.out            = a.get("--out",            o.out);
+        o.baseline       = a.get("--baseline",       o.baseline);
+        o.write_baseline = a.get("--write-baseline", o.write_baseline);
+        o.trials         = a.get("--trials",         o.trials);
+    } catch (const std::invalid_argument& e) {
+        std::cerr << "[bench] " << e.what() << '\n';
+        std::exit(2);
+    }
+    o.strict_host = a.is_present("--strict-host");
+    if (o.trials < 1) o.trials = 1;
+    return o;
+}
+
+// What "worse" means for a metric, and how much of it a baseline allows
+// unless it says otherwise.  Tolerances are relative to the baseline.
+enum class Better { Lower, Higher, Same };
+
+struct MetricKind {
+    const char* name;
+    Better      better;
+    double      tolerance;
+};
+
+static const MetricKind METRICS[] = {
+    { "p50_ns",     Better::Lower,  1.0 },  // may double
+    { "p99_ns",     Better::Lower,  9.0 },  // tails are noisy on shared hosts: 10x only
+    { "mevents_s",  Better::Higher, 0.5 },  // may halve
+    { "fault_rate", Better::Same,   0.0 },  // correctness: every trial must fault
+    { "trapped",    Better::Same,   0.0 },
+    { "ops_p50",    Better::Same,   0.0 },  // deterministic for a given glibc
+};
+
+static const MetricKind* metric_kind(const std::string& name)
+{
+    for (const auto& m : METRICS)
+        if (name == m.name) return &m;
+    return nullptr;
+}
+
+struct Scenario {
+    std::string                                  name;
+    std::vector<std::pair<std::string, double>>  metrics;
+};
+
+static std::size_t page_size()
+{
+#ifdef _WIN32
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    return static_cast<std::size_t>(si.dwPageSize);
+#else
+    return static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+// `trials` guarded runs after a short warm-up; latency percentiles + faults
+template <class F, class Cleanup>
+static Scenario guarded(const std::string& name, int trials, F&& fn, Cleanup&& cleanup)
+{
+    for (int i = 0; i < 10; ++i) { run_with_guard(fn); cleanup(); }
+    std::vector<long long> ns;
+    int faults = 0;
+    for (int i = 0; i < trials; ++i) {
+        const RunResult r = run_with_guard(fn);
+        cleanup();
+        ns.push_back(r.ns);
+        faults += r.crashed;
+    }
+    return { name, { { "p50_ns",     static_cast<double>(percentile(ns, 50)) },
+                     { "p99_ns",     static_cast<double>(percentile(ns, 99)) },
+                     { "fault_rate", static_cast<double>(faults) / trials } } };
+}
+
+// The catalogue.  Fixed on purpose: a baseline only means something if
+// every run measures the same things.
+static std::vector<Scenario> run_catalogue(const Opt& opt)
+{
+    std::vector<Scenario> out;
+    const std::size_t page = page_size();
+
+    // Fault kind 1: guard page after a heap block, near and far from it
+    for (std::size_t alloc : { std::size_t{ 16 }, std::size_t{ 4000 } }) {
+        const std::size_t over = (alloc + page - 1) / page * page - alloc + 64;
+        out.push_back(guarded("heap/" + std::to_string(alloc), opt.trials,
+                              [=] { run_heap_overflow(alloc, over, false); },
+                              release_heap_overflow_region));
+        std::cerr << "[bench] " << out.back().name << " done\n";
+    }
+
+#if !defined(_WIN32)
+    // Fault kind 2: store to a supervisor-only address
+    out.push_back(guarded("kernel", opt.trials,
+                          [] { run_kernel_access(0xFFFF000000000000ULL, false); }, [] {}));
+    std::cerr << "[bench] kernel done\n";
+#endif
+
+    // Fault kind 3: no guard at all, glibc's own checks abort (forks per trial)
+    {
+        std::vector<long long> ns, ops;
+        int  detected = 0, runs = 0, failed = 0;
+        bool supported = true;
+        for (; runs < 10 && supported; ++runs) {
+            run_malloc_corruption(64, 8, CorruptTarget::Size, 100000);
+            const MallocCorruptProfile& p = last_malloc_corruption_profile();
+            supported = p.check.rfind("unsupported", 0) != 0;
+            failed   += p.failed;
+            detected += p.detected;
+            if (p.detected) { ns.push_back(p.ns); ops.push_back(p.ops); }
+        }
+        if (supported) {
+            out.push_back({ "malloc/size", { { "p50_ns",     static_cast<double>(percentile(ns, 50)) },
+                                             { "ops_p50",    static_cast<double>(percentile(ops, 50)) },
+                                             { "fault_rate", runs > failed ? static_cast<double>(detected) / (runs - failed) : 0.0 } } });
+            std::cerr << "[bench] malloc/size done\n";
+        }
+    }
+
+    // Fault storm: the same synthetic trace replayed by 1, 2 and 4 threads
+    // faulting concurrently on Electric-Fence style guards
+    const std::string trace = opt.out + ".trace";
+    ReplayGenConfig gen;
+    gen.file         = trace;
+    gen.events       = 100000;
+    gen.shards       = 4;
+    gen.live         = 500;
+    gen.overrun_rate = 0.02;
+    std::streambuf* cout_buf = std::cout.rdbuf(nullptr);     // keep the generator quiet
+    const bool generated = generate_replay_trace(gen) == 0;
+    std::cout.rdbuf(cout_buf);
+    for (int threads : { 1, 2, 4 }) {
+        ReplayResult r;
+        if (!generated || !replay_trace(trace, ReplayGuard::PageEnd, threads, r)) break;
+        out.push_back({ "storm/" + std::to_string(threads),
+                        { { "mevents_s", r.mevents_per_s() },
+                          { "p50_ns",    static_cast<double>(r.fault_p50) },
+                          { "p99_ns",    static_cast<double>(r.fault_p99) },
+                          { "trapped",   static_cast<double>(r.trapped) } } });
+        std::cerr << "[bench] " << out.back().name << " done\n";
+    }
+    std::remove(trace.c_str());
+    return out;
+}
+
+// ------------------------------------------------------------ JSON
+
+static std::string number(double v)
+{
+    std::ostringstream s;
+    if (v == std::floor(v) && std::fabs(v) < 1e15) s << static_cast<long long>(v);
+    else                                           s << std::setprecision(6) << v;
+    return s.str();
+}
+
+static bool write_json(const std::string& path, const std::string& host,
+                       const std::vector<Scenario>& scenarios, bool with_tolerances)
+{
+    std::ofstream f(path);
+    f << "{\n  \"host\": \"" << host << "\",\n";
+    if (with_tolerances) {
+        f << "  \"tolerance\": {";
+        const char* sep = "\n";
+        for (const auto& m : METRICS) {
+            f << sep << "    \"" << m.name << "\": " << number(m.tolerance);
+            sep = ",\n";
+        }
+        f << "\n  },\n";
+    }
+    f << "  \"scenarios\": {";
+    const char* sep = "\n";
+    for (const auto& s : scenarios) {
+        f << sep << "    \"" << s.name << "\": {";
+        const char* msep = " ";
+        for (const auto& [k, v] : s.metrics) {
+            f << msep << '"' << k << "\": " << number(v);
+            msep = ", ";
+        }
+        f << " }";
+        sep = ",\n";
+    }
+    f << "\n  }\n}\n";
+    return static_cast<bool>(f);
+}
+
+// Just enough JSON for the files above: nested objects, strings and
+// numbers, flattened to "a.b.c" keys
+class JsonReader {
+public:
+    std::map<std::string, double>      numbers;
+    std::map<std::string, std::string> strings;
+
+    bool parse(const std::string& text)
+    {
+        p_ = text.c_str();
+        return value("") && (ws(), *p_ == '\0');
+    }
+
+private:
+    const char* p_ = nullptr;
+
+    void ws() { while (std::isspace(static_cast<unsigned char>(*p_))) ++p_; }
+
+    bool string(std::string& out)
+    {
+        if (*p_ != '"') return false;
+        for (++p_; *p_ && *p_ != '"'; ++p_) {
+            if (*p_ == '\\' && p_[1]) ++p_;
+            out += *p_;
+        }
+        if (*p_ != '"') return false;
+        ++p_;
+        return true;
+    }
+
+    bool value(const std::string& path)
+    {
+        ws();
+        if (*p_ == '"') {
+            std::string s;
+            if (!string(s)) return false;
+            strings[path] = s;
+            return true;
+        }
+        if (*p_ != '{') {
+            char* end = nullptr;
+            const double v = std::strtod(p_, &end);
+            if (end == p_) return false;
+            numbers[path] = v;
+            p_ = end;
+            return true;
+        }
+        ++p_;
+        ws();
+        if (*p_ == '}') { ++p_; return true; }
+        for (;;) {
+            ws();
+            std::string key;
+            if (!string(key)) return false;
+            ws();
+            if (*p_++ != ':') return false;
+            if (!value(path.empty() ? key : path + '.' + key)) return false;
+            ws();
+            if (*p_ == ',') { ++p_; continue; }
+            if (*p_ == '}') { ++p_; return true; }
+            return false;
+        }
+    }
+};
+
+// ------------------------------------------------------------ main
+
+int main(int argc, char** argv)
+{
+    const Opt opt = parse(argc, argv);
+    const std::string host = collect_host_fingerprint().config_hash();
+    std::cout << "[host] config " << host << '\n';
+
+    const std::vector<Scenario> scenarios = run_catalogue(opt);
+
+    std::stringstream out;
+    out << "\n| Scenario    | Metric     |         Value |\n"
+        <<   "|-------------|------------|--------------:|\n";
+    for (const auto& s : scenarios)
+        for (const auto& [k, v] : s.metrics)
+            out << "| " << std::left << std::setw(11) << s.name << " | " << std::setw(10) << k
+                << std::right << " | " << std::setw(13) << number(v) << " |\n";
+    zen::print(out.str());
+
+    if (!write_json(opt.out, host, scenarios, false)) {
+        std::cerr << "[bench] could not write " << opt.out << '\n';
+        return 2;
+    }
+    std::cout << "[bench] results → " << opt.out << '\n';
+    if (!opt.write_baseline.empty()) {
+        if (!write_json(opt.write_baseline, host, scenarios, true)) {
+            std::cerr << "[bench] could not write " << opt.write_baseline << '\n';
+            return 2;
+        }
+        std::cout << "[bench] baseline → " << opt.write_baseline << '\n';
+    }
+    if (opt.baseline.empty()) return 0;
+
+    std::ifstream in(opt.baseline);
+    std::stringstream text;
+    text << in.rdbuf();
+    JsonReader base;
+    if (!in || !base.parse(text.str())) {
+        std::cerr << "[bench] cannot read baseline " << opt.baseline << '\n';
+        return 2;
+    }
+
+    std::map<std::string, double> now;
+    for (const auto& s : scenarios)
+        for (const auto& [k, v] : s.metrics) now["scenarios." + s.name + '.' + k] = v;
+
+    int failed = 0, skipped = 0;
+    std::stringstream cmp;
+    cmp << "\n| Scenario    | Metric     |      Baseline |           Now |   Change |  Allowed | OK  |\n"
+        <<   "|-------------|------------|--------------:|--------------:|---------:|---------:|-----|\n";
+    for (const auto& [key, was] : base.numbers) {
+        if (key.rfind("scenarios.", 0) != 0) continue;
+        const std::size_t dot    = key.rfind('.');
+        const std::string metric = key.substr(dot + 1);
+        const std::string name   = key.substr(10, dot - 10);
+        const MetricKind* kind   = metric_kind(metric);
+        const auto        it     = now.find(key);
+        if (!kind || it == now.end()) { ++skipped; continue; }     // not measured on this platform
+
+        const auto   tol_it = base.numbers.find("tolerance." + metric);
+        const double tol    = tol_it != base.numbers.end() ? tol_it->second : kind->tolerance;
+        const double is     = it->second;
+        const double change = was != 0 ? is / was - 1.0 : (is != 0 ? 1.0 : 0.0);
+        bool ok = true;
+        switch (kind->better) {
+            case Better::Lower:  ok = change <= tol;              break;
+            case Better::Higher: ok = change >= -tol;             break;
+            case Better::Same:   ok = std::fabs(change) <= tol;   break;
+        }
+        failed += !ok;
+        cmp << "| " << std::left << std::setw(11) << name << " | " << std::setw(10) << metric << std::right
+            << " | " << std::setw(13) << number(was) << " | " << std::setw(13) << number(is) << " | "
+            << std::showpos << std::fixed << std::setprecision(1) << std::setw(7) << change * 100 << "% | "
+            << std::noshowpos << (kind->better == Better::Higher ? '-' : kind->better == Better::Same ? ' ' : '+')
+            << std::setw(6) << tol * 100 << "% | " << (ok ? "yes" : "NO ") << " |\n" << std::defaultfloat;
+    }
+    zen::print(cmp.str());
+    if (skipped) std::cout << "[bench] " << skipped << " baseline metric(s) not measured here\n";
+
+    const auto base_host = base.strings.find("host");
+    const bool same_host = base_host != base.strings.end() && base_host->second == host;
+    if (failed && !same_host && !opt.strict_host) {
+        std::cout << "[bench] " << failed << " metric(s) outside tolerance, but the baseline comes from host "
+                  << (base_host != base.strings.end() ? base_host->second : "?")
+                  << "; advisory only (--strict-host to enforce)\n";
+        return 0;
+    }
+    std::cout << "[bench] " << (failed ? std::to_string(failed) + " metric(s) outside tolerance"
+                                       : std::string("all metrics within tolerance")) << '\n';
+    return failed ? 1 : 0;
+}
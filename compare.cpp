@@ -0,0 +1,261 @@
+#ifdef _WIN32
+#   define _CRT_SECURE_NO_WARNINGS        // silence MSVC CRT warnings
+#endif
+
+// mem_crash_compare — gate a new result set against a baseline.
+//
+// Both CSVs are walked row by row, mapped or (pipes) read in chunks: every
+// sample lands in a fixed-size latency histogram (exact counts, ~6 % bins)
+// and a bounded reservoir sample.  Percentile deltas, the bootstrap CI and
+// the Mann-Whitney U test come from the reservoirs, whose values are exact
+// (all of them up to --reservoir samples): the bins are coarser than the
+// threshold.  Only a p99 of more samples than the reservoir holds is read
+// off the histograms, since a sample sees too little of the tail.  Memory
+// does not grow with the file size.
+
+#include "latency_histogram.h"
+#include "stats.h"
+#include "kaizen.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct Opt {
+    std::string base, next;
+    double      alpha       = 0.01;     // significance level of the U test
+    double      threshold   = 0.05;     // smallest p50 slowdown that counts
+    std::size_t reservoir   = 10000;    // samples kept per test and side
+    int         resamples   = 1000;     // bootstrap iterations
+    bool        keep_disturbed = false;
+};
+
+// Accepts "5%" or "0.05": a bare number is always a fraction, and anything
+// outside [0, 1] is rejected rather than guessed at
+static double parse_ratio(const std::string& s)
+{
+    const bool   pct = !s.empty() && s.back() == '%';
+    const double v   = std::stod(s) / (pct ? 100.0 : 1.0);
+    if (!(v >= 0.0 && v <= 1.0))
+        throw std::invalid_argument("'" + s + "' is not a ratio: use a fraction (0.05) or a percentage (5%)");
+    return v;
+}
+
+static Opt parse(int argc, char** argv)
+{
+    zen::cmd_args a(argv, argc);
+    Opt o;
+    if (argc < 3 || argv[1][0] == '-' || argv[2][0] == '-' || a.is_present("--help")) {
+        std::cout << "Usage: " << argv[0] << " BASE.csv NEW.csv [--alpha P] [--threshold P%] "
+                  << "[--reservoir N] [--resamples N] [--keep-disturbed]\n"
+                  << "Exit status: 0 = no regression, 1 = significant regression, 2 = error\n";
+        std::exit(a.is_present("--help") ? 0 : 2);
+    }
+    o.base = argv[1];
+    o.next = argv[2];
+    try {
+        o.alpha     = a.get("--alpha",     o.alpha);
+        o.reservoir = a.get("--reservoir", o.reservoir);
+        o.resamples = a.get("--resamples", o.resamples);
+        if (a.is_present("--threshold")) o.threshold = parse_ratio(a.get<std::string>("--threshold"));
+    } catch (const std::invalid_argument& e) {
+        std::cerr << "[compare] " << e.what() << '\n';
+        std::exit(2);
+    }
+    o.keep_disturbed = a.is_present("--keep-disturbed");
+    if (o.reservoir < 1) o.reservoir = 1;
+    return o;
+}
+
+// Everything kept for one test of one result set
+struct Side {
+    LatencyHistogram       hist;
+    std::vector<long long> sample;      // uniform reservoir (Li's algorithm L)
+    std::uint64_t          seen = 0;
+    std::uint64_t          next = 0;    // 1-based index of the next item to keep
+    double                 w    = 0.0;
+};
+
+struct Test {
+    std::string name;
+    Side        side[2];
+};
+
+class Reservoir {
+public:
+    explicit Reservoir(std::size_t k) : k_(k), rng_(0x6d656d5f63726173ULL) {}
+
+    void add(Side& s, long long v)
+    {
+        ++s.seen;
+        if (s.sample.size() < k_) {
+            s.sample.push_back(v);
+            if (s.sample.size() == k_) {
+                s.w = std::exp(std::log(unit()) / static_cast<double>(k_));
+                skip(s);
+            }
+            return;
+        }
+        if (s.seen != s.next) return;
+        s.sample[std::uniform_int_distribution<std::size_t>(0, k_ - 1)(rng_)] = v;
+        s.w *= std::exp(std::log(unit()) / static_cast<double>(k_));
+        skip(s);
+    }
+
+private:
+    double unit()
+    {
+        // (0, 1]: log() must stay finite
+        return 1.0 - std::uniform_real_distribution<double>(0.0, 1.0)(rng_);
+    }
+
+    void skip(Side& s)
+    {
+        const double gap = std::floor(std::log(unit()) / std::log1p(-s.w));
+        s.next = s.seen + 1 + (gap < 1e18 ? static_cast<std::uint64_t>(gap) : std::uint64_t(1) << 62);
+    }
+
+    std::size_t     k_;
+    std::mt19937_64 rng_;
+};
+
+// Walks one result CSV (fingerprint '#' lines allowed) into `tests`; rows
+// are not kept, so a pipe is read with flat memory too
+static bool load(const std::string& path, int which, const Opt& opt,
+                 std::vector<Test>& tests, Reservoir& res)
+{
+    std::optional<zen::csv_reader> csv;
+    try {
+        csv.emplace(path);
+    } catch (const std::exception&) {
+        std::cerr << "[compare] cannot open " << path << '\n';
+        return false;
+    }
+    if (csv->column("Test") < 0 || csv->column("Time_ns") < 0) {
+        std::cerr << "[compare] " << path << ": no Test/Time_ns header\n";
+        return false;
+    }
+    const bool drop_disturbed = !opt.keep_disturbed && csv->column("Disturbed") >= 0;
+    if (drop_disturbed) csv->select({ "Test", "Time_ns", "Disturbed" });
+    else                csv->select({ "Test", "Time_ns" });
+
+    std::size_t last = 0;                // tests usually interleave: cheap lookup hint
+    std::uint64_t rows = 0, skipped = 0;
+    for (const auto& row : *csv) {
+        if (drop_disturbed && row[2] == "1") { ++skipped; continue; }
+
+        const std::string_view name = row[0];
+        long long ns = 0;
+        if (!row.get(1, ns) || ns < 0) { ++skipped; continue; }
+
+        if (last >= tests.size() || tests[last].name != name) {
+            last = 0;
+            while (last < tests.size() && tests[last].name != name) ++last;
+            if (last == tests.size()) tests.push_back({ std::string(name), {} });
+        }
+        Side& s = tests[last].side[which];
+        s.hist.add(static_cast<std::uint64_t>(ns));
+        res.add(s, ns);
+        ++rows;
+    }
+
+    std::cout << "[compare] " << path << ": " << rows << " rows";
+    if (skipped) std::cout << " (" << skipped << " skipped)";
+    std::cout << '\n';
+    return true;
+}
+
+// Percentile bootstrap of the relative p50 shift new/base - 1
+static std::pair<double, double> bootstrap_p50(const std::vector<long long>& a,
+                                               const std::vector<long long>& b, int resamples)
+{
+    std::mt19937_64 rng(0x626f6f74ULL);
+    std::vector<long long> ra(a.size()), rb(b.size());
+    std::vector<long long> deltas_x1e6;
+    deltas_x1e6.reserve(static_cast<std::size_t>(std::max(resamples, 1)));
+
+    // Nearest-rank median of a resample, same rank as percentile(…, 50)
+    auto draw = [&rng](const std::vector<long long>& src, std::vector<long long>& dst) {
+        std::uniform_int_distribution<std::size_t> pick(0, src.size() - 1);
+        for (auto& x : dst) x = src[pick(rng)];
+        const auto mid = dst.begin() + static_cast<std::ptrdiff_t>((dst.size() + 1) / 2 - 1);
+        std::nth_element(dst.begin(), mid, dst.end());
+        return *mid;
+    };
+    for (int i = 0; i < resamples; ++i) {
+        const long long ma = draw(a, ra), mb = draw(b, rb);
+        if (ma > 0)
+            deltas_x1e6.push_back(static_cast<long long>((static_cast<double>(mb) / ma - 1.0) * 1e6));
+    }
+    if (deltas_x1e6.empty()) return { 0.0, 0.0 };
+    return { percentile(deltas_x1e6, 2.5) / 1e6, percentile(deltas_x1e6, 97.5) / 1e6 };
+}
+
+static double rel(std::uint64_t base, std::uint64_t next)
+{
+    return base ? static_cast<double>(next) / static_cast<double>(base) - 1.0 : 0.0;
+}
+
+static double rel(long long base, long long next)
+{
+    return rel(static_cast<std::uint64_t>(base), static_cast<std::uint64_t>(next));
+}
+
+int main(int argc, char** argv)
+{
+    const Opt opt = parse(argc, argv);
+
+    std::vector<Test> tests;
+    Reservoir res(opt.reservoir);
+    if (!load(opt.base, 0, opt, tests, res) || !load(opt.next, 1, opt, tests, res))
+        return 2;
+
+    bool regressed = false;
+    std::cout << "\n| Test   |   N base |    N new | Δp50    | Δp90    | Δp99    | p50 95% CI        | "
+                 "U p-value | Verdict    |\n"
+              << "|--------|---------:|---------:|--------:|--------:|--------:|:-----------------:|"
+                 "----------:|------------|\n";
+    for (const auto& t : tests) {
+        const Side& a = t.side[0];
+        const Side& b = t.side[1];
+        std::cout << "| " << std::left << std::setw(6) << t.name << std::right << " | "
+                  << std::setw(8) << a.seen << " | " << std::setw(8) << b.seen << " | ";
+        if (!a.seen || !b.seen) {
+            std::cout << "      – |       – |       – |                 – |         – | "
+                      << std::left << std::setw(10) << (a.seen ? "gone" : "new") << std::right << " |\n";
+            continue;
+        }
+
+        const double d50 = rel(percentile(a.sample, 50), percentile(b.sample, 50));
+        const double d90 = rel(percentile(a.sample, 90), percentile(b.sample, 90));
+        const bool   all = a.seen == a.sample.size() && b.seen == b.sample.size();
+        const double d99 = all ? rel(percentile(a.sample, 99), percentile(b.sample, 99))
+                               : rel(a.hist.quantile(0.99), b.hist.quantile(0.99));
+        const auto   ci  = bootstrap_p50(a.sample, b.sample, opt.resamples);
+        const MannWhitney mw = mann_whitney(a.sample, b.sample);
+
+        // Slower with statistical confidence *and* by more than the threshold
+        const bool slower = mw.p_greater < opt.alpha && d50 > opt.threshold;
+        const bool faster = mw.p_greater > 1.0 - opt.alpha && d50 < -opt.threshold;
+        regressed |= slower;
+
+        std::cout << std::showpos << std::fixed << std::setprecision(1)
+                  << std::setw(6) << d50 * 100 << "% | " << std::setw(6) << d90 * 100 << "% | "
+                  << std::setw(6) << d99 * 100 << "% | "
+                  << std::setw(6) << ci.first * 100 << "% … " << std::setw(6) << ci.second * 100 << "% | "
+                  << std::noshowpos << std::scientific << std::setprecision(2)
+                  << std::setw(9) << mw.p_greater << " | " << std::defaultfloat
+                  << std::left << std::setw(10) << (slower ? "REGRESSION" : faster ? "faster" : "ok")
+                  << std::right << " |\n";
+    }
+    std::cout << "\nΔ = new vs. base; U p-value is one-sided (new slower), α = " << opt.alpha
+              << ", threshold = " << opt.threshold * 100 << "% on p50\n";
+    return regressed ? 1 : 0;
+}
@@ -0,0 +1,199 @@
+#include "corunner.h"
+#include "crash_guard.h"
+#include "interference.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+#ifdef _WIN32
+#  include <windows.h>
+#else
+#  include <unistd.h>
+#  include <sys/mman.h>
+#  if defined(__linux__)
+#    include <sys/syscall.h>
+#  endif
+#endif
+
+namespace {
+
+constexpr std::size_t PAGE      = 4096;
+constexpr std::size_t TLB_BYTES = std::size_t(256) << 20;   // per worker, until ...
+constexpr std::size_t TLB_TOTAL = std::size_t(4) << 30;     // ... all of them would map more
+constexpr std::size_t TLB_MIN   = std::size_t(32) << 20;    // still ~4x a large STLB's reach
+constexpr std::size_t STREAM_N  = std::size_t(2) << 20;    // doubles per array (16 MiB)
+constexpr std::size_t CHURN_LEN = 16 * PAGE;
+
+void* map_anon(std::size_t len)
+{
+#ifdef _WIN32
+    return VirtualAlloc(nullptr, len, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+    void* p = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return p == MAP_FAILED ? nullptr : p;
+#endif
+}
+
+void unmap_anon(void* p, std::size_t len)
+{
+#ifdef _WIN32
+    (void)len;
+    VirtualFree(p, 0, MEM_RELEASE);
+#else
+    munmap(p, len);
+#endif
+}
+
+// Cheapest call that still enters the kernel every time
+void trivial_syscall()
+{
+#if defined(_WIN32)
+    SwitchToThread();
+#elif defined(__linux__)
+    syscall(SYS_getppid);      // glibc would not cache it, but be explicit
+#else
+    (void)getppid();
+#endif
+}
+
+} // namespace
+
+const char* load_name(Load l)
+{
+    switch (l) {
+        case Load::Idle:    return "idle";
+        case Load::Stream:  return "stream";
+        case Load::Tlb:     return "tlb";
+        case Load::Mmap:    return "mmap";
+        case Load::Syscall: return "syscall";
+    }
+    return "?";
+}
+
+bool parse_load(const std::string& s, Load& out)
+{
+    for (Load l : { Load::Idle, Load::Stream, Load::Tlb, Load::Mmap, Load::Syscall })
+        if (s == load_name(l)) { out = l; return true; }
+    return false;
+}
+
+std::vector<int> default_load_cpus(int measure_cpu)
+{
+    const int n = static_cast<int>(std::thread::hardware_concurrency());
+    std::vector<int> cpus;
+    for (int c = 0; c < n; ++c)
+        if (c != measure_cpu) cpus.push_back(c);
+    if (cpus.empty()) cpus.push_back(-1);
+    return cpus;
+}
+
+CoRunner::CoRunner(Load load, const std::vector<int>& cpus) : load_(load)
+{
+    start_ns_ = guard_clock_ns();
+    if (load_ == Load::Idle)
+        return;
+    tlb_bytes_ = std::max(std::min(TLB_BYTES, TLB_TOTAL / std::max<std::size_t>(cpus.size(), 1)), TLB_MIN)
+               / PAGE * PAGE;
+    for (int cpu : cpus)
+        threads_.emplace_back(&CoRunner::work, this, cpu);
+
+    // Trials only start once every worker has its memory set up and runs
+    while (ready_.load() < static_cast<int>(threads_.size()))
+        std::this_thread::yield();
+    start_ns_ = guard_clock_ns();
+}
+
+CoRunner::~CoRunner()
+{
+    stop();
+}
+
+double CoRunner::stop()
+{
+    if (threads_.empty())
+        return rate_;
+    stop_.store(true, std::memory_order_relaxed);
+    for (auto& t : threads_) t.join();
+    threads_.clear();
+
+    const double s = static_cast<double>(guard_clock_ns() - start_ns_) / 1e9;
+    double units = static_cast<double>(units_.load());
+    if (load_ == Load::Stream) units /= 1e9;               // bytes → GB
+    rate_ = s > 0 ? units / s : 0.0;
+    return rate_;
+}
+
+const char* CoRunner::rate_unit() const
+{
+    switch (load_) {
+        case Load::Stream:  return "GB/s";
+        case Load::Tlb:     return "page touches/s";
+        case Load::Mmap:    return "map+unmap/s";
+        case Load::Syscall: return "syscalls/s";
+        default:            return "";
+    }
+}
+
+void CoRunner::work(int cpu)
+{
+    if (cpu >= 0) pin_to_cpu(cpu);
+    std::uint64_t done = 0;
+
+    switch (load_) {
+    case Load::Stream: {
+        // STREAM triad; arrays are allocated here so they are node-local
+        std::vector<double> a(STREAM_N, 1.0), b(STREAM_N, 2.0), c(STREAM_N, 0.5);
+        constexpr std::size_t BLOCK = 1 << 16;
+        ready_.fetch_add(1);
+        while (!stop_.load(std::memory_order_relaxed)) {
+            for (std::size_t j = 0; j < STREAM_N && !stop_.load(std::memory_order_relaxed); j += BLOCK) {
+                for (std::size_t i = j; i < j + BLOCK; ++i) a[i] = b[i] + 3.0 * c[i];
+                done += 3 * BLOCK * sizeof(double);
+            }
+            std::swap(a, b);
+        }
+        break;
+    }
+    case Load::Tlb: {
+        auto* mem = static_cast<volatile unsigned char*>(map_anon(tlb_bytes_));
+        if (!mem) { ready_.fetch_add(1); break; }
+#if defined(MADV_NOHUGEPAGE)
+        madvise(const_cast<unsigned char*>(mem), tlb_bytes_, MADV_NOHUGEPAGE);   // keep 4 KiB entries
+#endif
+        const std::size_t pages = tlb_bytes_ / PAGE;
+        for (std::size_t p = 0; p < pages; ++p) mem[p * PAGE] = 1;
+        ready_.fetch_add(1);
+        std::uint64_t x = 0x9E3779B97F4A7C15ULL ^ static_cast<std::uint64_t>(cpu + 2);
+        while (!stop_.load(std::memory_order_relaxed)) {
+            for (int i = 0; i < 4096; ++i) {
+                x ^= x << 13; x ^= x >> 7; x ^= x << 17;       // xorshift64
+                mem[(x % pages) * PAGE + (x >> 52) % 64 * 64] += 1;
+            }
+            done += 4096;
+        }
+        unmap_anon(const_cast<unsigned char*>(mem), tlb_bytes_);
+        break;
+    }
+    case Load::Mmap:
+        ready_.fetch_add(1);
+        while (!stop_.load(std::memory_order_relaxed)) {
+            auto* p = static_cast<volatile unsigned char*>(map_anon(CHURN_LEN));
+            if (!p) continue;
+            for (std::size_t off = 0; off < CHURN_LEN; off += PAGE) p[off] = 1;
+            unmap_anon(const_cast<unsigned char*>(p), CHURN_LEN);
+            ++done;
+        }
+        break;
+    case Load::Syscall:
+        ready_.fetch_add(1);
+        while (!stop_.load(std::memory_order_relaxed)) {
+            for (int i = 0; i < 256; ++i) trivial_syscall();
+            done += 256;
+        }
+        break;
+    case Load::Idle:
+        break;
+    }
+    units_.fetch_add(done);
+}
@@ -0,0 +1,67 @@
+#ifndef CORUNNER_H
+#define CORUNNER_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Background load that runs on other cores while trials execute, so
+ * fault latency can be measured under realistic contention instead of on
+ * an idle machine.
+ */
+enum class Load {
+    Idle,       // no co-runners
+    Stream,     // memory-bandwidth triad over buffers far larger than LLC
+    Tlb,        // random page touches over 256 MiB of 4 KiB pages (4 GiB in all at most)
+    Mmap,       // mmap / touch / munmap churn → mmap_lock and TLB shootdowns
+    Syscall,    // tight loop of trivial system calls
+};
+
+const char* load_name(Load l);
+
+/** Parses "idle", "stream", "tlb", "mmap" or "syscall"; false if unknown. */
+bool parse_load(const std::string& s, Load& out);
+
+/**
+ * Starts one worker per entry of `cpus` (each pinned to it; -1 = unpinned)
+ * on construction and stops and joins them on destruction.  Idle starts
+ * nothing.
+ */
+class CoRunner {
+public:
+    CoRunner(Load load, const std::vector<int>& cpus);
+    ~CoRunner();
+
+    CoRunner(const CoRunner&)            = delete;
+    CoRunner& operator=(const CoRunner&) = delete;
+
+    /** Stops the workers; returns units of work per second while they ran. */
+    double stop();
+
+    /** Unit `stop()` reports in, e.g. "GB/s" or "ops/s". */
+    const char* rate_unit() const;
+
+private:
+    void work(int cpu);
+
+    Load                       load_;
+    std::atomic<bool>          stop_{ false };
+    std::atomic<std::uint64_t> units_{ 0 };
+    std::atomic<int>           ready_{ 0 };     // workers past their setup
+    std::vector<std::thread>   threads_;
+    std::size_t                tlb_bytes_ = 0;  // Tlb: mapping per worker
+    long long                  start_ns_ = 0;
+    double                     rate_     = 0.0;
+};
+
+/**
+ * CPUs to put co-runners on when none are given: every online CPU except
+ * `measure_cpu`, or one unpinned worker on a single-CPU machine.  The
+ * measuring thread should be pinned to `measure_cpu`, or the co-runners
+ * preempt it instead of contending with it.
+ */
+std::vector<int> default_load_cpus(int measure_cpu);
+#endif // CORUNNER_H
@@ -0,0 +1,130 @@
+#include "crash_guard.h"
+#include "fault_ring.h"
+#include "trial_trace.h"
+#include <chrono>
+#include <csignal>
+#include <iostream>
+
+#if defined(_WIN32)            // -------- Windows : ISO setjmp/longjmp
+    #include <setjmp.h>
+    static jmp_buf JUMP_BUF;
+    #define SETJMP(env)    setjmp(env)
+    #define LONGJMP(env,v) longjmp(env,v)
+    #include <windows.h>
+    #include <eh.h>                 // _set_se_translator
+#else                              // -------- POSIX : sigsetjmp/siglongjmp
+    #include <csetjmp>
+    static sigjmp_buf JUMP_BUF;
+    #define SETJMP(env)    sigsetjmp(env,1)
+    #define LONGJMP(env,v) siglongjmp(env,v)
+#endif
+
+using Clock = std::chrono::steady_clock;
+
+// Start stamp lives outside the guarded frame so it survives the longjmp
+static Clock::time_point START;
+
+// Filled in by the handler, read back once we have recovered
+static volatile std::sig_atomic_t FAULT_SIGNAL = 0;
+static volatile std::uintptr_t    FAULT_ADDR   = 0;
+
+#if defined(_WIN32)
+// SEH filter: remember the faulting data address of an access violation
+static int seh_filter(EXCEPTION_POINTERS* ep)
+{
+    const EXCEPTION_RECORD* er = ep->ExceptionRecord;
+    FAULT_SIGNAL = SIGSEGV;
+    if (er->ExceptionCode == EXCEPTION_ACCESS_VIOLATION && er->NumberParameters >= 2)
+        FAULT_ADDR = static_cast<std::uintptr_t>(er->ExceptionInformation[1]);
+    fault_ring_push(SIGSEGV, static_cast<int>(er->ExceptionCode), FAULT_ADDR);
+    return EXCEPTION_EXECUTE_HANDLER;
+}
+#else
+// Handler for segmentation fault signal; si_addr is the faulting address
+static void segv_handler(int sig, siginfo_t* info, void*)
+{
+    trace_fault();
+    FAULT_SIGNAL = sig;
+    FAULT_ADDR   = reinterpret_cast<std::uintptr_t>(info->si_addr);
+    fault_ring_push(sig, info->si_code, FAULT_ADDR);
+    trace_end(TracePhase::Handler);
+    trace_begin(TracePhase::Recovery);
+    LONGJMP(JUMP_BUF, 1);
+}
+#endif
+
+static long long stamp_ns(Clock::time_point t)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+}
+
+long long guard_clock_ns()
+{
+    return stamp_ns(Clock::now());
+}
+
+// Function to run the tests with a guard against crashes
+RunResult run_with_guard(const std::function<void()>& fn)
+{
+    Clock::time_point t1;
+    RunResult r;
+
+    FAULT_SIGNAL = 0;
+    FAULT_ADDR   = 0;
+    fault_ring_attach();
+
+    const InterferenceSnapshot before = take_interference_snapshot();
+
+#if defined(_WIN32)  // SEH for Windows
+    if (SETJMP(JUMP_BUF) == 0) {
+        __try {
+            START = Clock::now();
+            fn();
+            t1 = Clock::now();
+            r.crashed = false;
+        }
+        __except(seh_filter(GetExceptionInformation())) {
+            t1 = Clock::now();
+            trace_fault();
+            trace_end(TracePhase::Handler);
+            r.crashed = true;
+            std::cerr << "Access violation occurred (SEH)\n";
+        }
+    } else {
+        t1 = Clock::now();
+        r.crashed = true;
+    }
+#else  // ---------- POSIX ------------------------------
+    struct sigaction sa{}, old_segv{}, old_abrt{};
+    sa.sa_sigaction = segv_handler;
+    sa.sa_flags     = SA_SIGINFO;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGSEGV, &sa, &old_segv);
+    sigaction(SIGABRT, &sa, &old_abrt);   // catch allocator aborts
+
+    if (SETJMP(JUMP_BUF) == 0) {
+        START = Clock::now();
+        fn();                 // may smash the heap
+        t1 = Clock::now();
+        r.crashed = false;
+    } else {
+        t1 = Clock::now();
+        trace_end(TracePhase::Recovery);
+        r.crashed = true;     // we jumped back from SIGSEGV or SIGABRT
+    }
+
+    // restore previous dispositions
+    sigaction(SIGSEGV, &old_segv, nullptr);
+    sigaction(SIGABRT, &old_abrt, nullptr);
+#endif
+
+    const InterferenceSnapshot after = take_interference_snapshot();
+
+    r.ns         = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - START).count();
+    r.end_ns     = stamp_ns(t1);
+    r.signal     = r.crashed ? static_cast<int>(FAULT_SIGNAL) : 0;
+    r.fault_addr = r.crashed ? FAULT_ADDR : 0;
+    r.noise      = interference_between(before, after);
+    r.disturbed  = r.noise.disturbed();
+    return r;
+}
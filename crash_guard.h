@@ -0,0 +1,34 @@
+#ifndef CRASH_GUARD_H
+#define CRASH_GUARD_H
+
+#include "interference.h"
+#include <cstdint>
+#include <functional>
+
+/**
+ * Outcome of one guarded trial.  `disturbed` is set when the window saw
+ * a context switch, a CPU migration or an interrupt on its CPU, i.e. the
+ * sample may measure scheduler noise instead of the fault path.
+ */
+struct RunResult {
+    bool           crashed{};
+    long long      ns{};
+    long long      end_ns{};      // guard_clock_ns() stamp at finish/recovery
+    int            signal{};      // SIGSEGV / SIGABRT that ended the run, 0 if none
+    std::uintptr_t fault_addr{};  // si_addr of the fault, 0 if none/unknown
+    Interference   noise{};
+    bool           disturbed{};
+};
+
+/**
+ * Runs `fn` with SIGSEGV/SIGABRT (SEH on Windows) redirected back here
+ * and returns how long it took until it finished or crashed.
+ */
+RunResult run_with_guard(const std::function<void()>& fn);
+
+/**
+ * Monotonic nanosecond stamp on the clock the guard times with, so code
+ * inside `fn` can mark points that are later compared with `end_ns`.
+ */
+long long guard_clock_ns();
+#endif // CRASH_GUARD_H
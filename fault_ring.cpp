@@ -0,0 +1,139 @@
+#include "fault_ring.h"
+#include "crash_guard.h"
+
+#include <atomic>
+#include <mutex>
+
+#ifdef _WIN32
+#  include <windows.h>
+#else
+#  include <sched.h>
+#  include <unistd.h>
+#  if defined(__linux__)
+#    include <sys/syscall.h>
+#  endif
+#endif
+
+static_assert((FAULT_RING_CAPACITY & (FAULT_RING_CAPACITY - 1)) == 0, "capacity must be a power of two");
+
+namespace {
+
+// Single producer (the owning thread, usually inside a handler), single
+// consumer (whoever drains).  The indices only ever grow.
+struct Ring {
+    alignas(64) std::atomic<std::uint64_t> head{ 0 };   // written by the producer
+    alignas(64) std::atomic<std::uint64_t> tail{ 0 };   // written by the consumer
+    std::atomic<bool>                      owned{ true };
+    std::uint32_t                          tid = 0;
+    FaultRecord                            slots[FAULT_RING_CAPACITY];
+};
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "ring indices must be lock-free");
+
+constexpr std::size_t MAX_RINGS = 256;
+
+std::atomic<Ring*>         RINGS[MAX_RINGS];
+std::atomic<std::size_t>   RING_COUNT{ 0 };
+std::mutex                 ATTACH_LOCK;       // attach only; never taken in a handler
+std::atomic<std::uint64_t> DROPPED{ 0 };
+std::atomic<bool>          ENABLED{ false };
+
+thread_local Ring* T_RING = nullptr;
+
+// Hands the ring back when its thread exits
+struct Detach {
+    ~Detach() { if (T_RING) T_RING->owned.store(false, std::memory_order_release); }
+};
+thread_local Detach T_DETACH;
+
+std::uint32_t current_tid()
+{
+#if defined(_WIN32)
+    return static_cast<std::uint32_t>(GetCurrentThreadId());
+#elif defined(__linux__)
+    return static_cast<std::uint32_t>(syscall(SYS_gettid));
+#else
+    return 0;
+#endif
+}
+
+// glibc ≥ 2.35 reads this from the rseq area, older ones from the vDSO
+int current_cpu()
+{
+#if defined(_WIN32)
+    return static_cast<int>(GetCurrentProcessorNumber());
+#elif defined(__linux__)
+    return sched_getcpu();
+#else
+    return -1;
+#endif
+}
+
+} // namespace
+
+void fault_ring_enable() { ENABLED.store(true, std::memory_order_release); }
+
+void fault_ring_attach()
+{
+    if (T_RING || !ENABLED.load(std::memory_order_acquire)) return;
+    (void)&T_DETACH;                // construct it so the ring is released at exit
+    std::lock_guard<std::mutex> lock(ATTACH_LOCK);
+
+    // An exited thread's ring is reused once everything in it was drained
+    Ring* ring = nullptr;
+    const std::size_t n = RING_COUNT.load(std::memory_order_acquire);
+    for (std::size_t i = 0; i < n && !ring; ++i) {
+        Ring* r = RINGS[i].load(std::memory_order_acquire);
+        if (!r->owned.load(std::memory_order_acquire)
+            && r->head.load(std::memory_order_acquire) == r->tail.load(std::memory_order_acquire))
+            ring = r;
+    }
+    if (!ring) {
+        if (n == MAX_RINGS) return;                 // faults of this thread count as dropped
+        ring = new Ring;                            // lives until exit; drains may still read it
+        RINGS[n].store(ring, std::memory_order_release);
+        RING_COUNT.store(n + 1, std::memory_order_release);
+    }
+    ring->tid = current_tid();
+    ring->owned.store(true, std::memory_order_release);
+    T_RING = ring;
+}
+
+void fault_ring_push(int signo, int code, std::uintptr_t addr)
+{
+    Ring* r = T_RING;
+    if (!r) {
+        if (ENABLED.load(std::memory_order_relaxed)) DROPPED.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    const std::uint64_t head = r->head.load(std::memory_order_relaxed);
+    if (head - r->tail.load(std::memory_order_acquire) >= FAULT_RING_CAPACITY) {
+        DROPPED.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    FaultRecord& rec = r->slots[head & (FAULT_RING_CAPACITY - 1)];
+    rec.ns    = guard_clock_ns();
+    rec.addr  = addr;
+    rec.signo = signo;
+    rec.code  = code;
+    rec.tid   = r->tid;
+    rec.cpu   = current_cpu();
+    r->head.store(head + 1, std::memory_order_release);
+}
+
+std::size_t fault_ring_drain(std::vector<FaultRecord>& out)
+{
+    const std::size_t before = out.size();
+    const std::size_t n      = RING_COUNT.load(std::memory_order_acquire);
+    for (std::size_t i = 0; i < n; ++i) {
+        Ring*               r    = RINGS[i].load(std::memory_order_acquire);
+        const std::uint64_t head = r->head.load(std::memory_order_acquire);
+        std::uint64_t       tail = r->tail.load(std::memory_order_relaxed);
+        for (; tail != head; ++tail) out.push_back(r->slots[tail & (FAULT_RING_CAPACITY - 1)]);
+        r->tail.store(tail, std::memory_order_release);
+    }
+    return out.size() - before;
+}
+
+std::uint64_t fault_ring_dropped() { return DROPPED.load(std::memory_order_relaxed); }
@@ -0,0 +1,51 @@
+#ifndef FAULT_RING_H
+#define FAULT_RING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/** One fault as seen by a signal handler (or the SEH filter on Windows). */
+struct FaultRecord {
+    long long      ns     = 0;    // guard_clock_ns() at handler entry
+    std::uintptr_t addr   = 0;    // si_addr / faulting data address
+    std::int32_t   signo  = 0;
+    std::int32_t   code   = 0;    // si_code, e.g. SEGV_ACCERR
+    std::uint32_t  tid    = 0;
+    std::int32_t   cpu    = -1;   // CPU the handler ran on, -1 if unknown
+};
+
+constexpr std::size_t FAULT_RING_CAPACITY = 4096;   // records per thread, power of two
+
+/**
+ * Turns recording on for the rest of the run.  Until then attach and push
+ * do nothing, so the handlers cost one thread-local load.
+ */
+void fault_ring_enable();
+
+/**
+ * Gives the calling thread its own single-producer ring; call it from
+ * normal context on every thread that may fault before it does (cheap
+ * and idempotent after the first call).  Rings of threads that exit are
+ * kept until drained and then reused.
+ */
+void fault_ring_attach();
+
+/**
+ * Records a fault from inside a signal handler: async-signal-safe,
+ * lock-free, no allocation and no system call (the thread id is cached
+ * at attach time).  Threads that never attached, or whose ring is full,
+ * only bump the drop counter.
+ */
+void fault_ring_push(int signo, int code, std::uintptr_t addr);
+
+/**
+ * Moves every record pushed so far, from every thread's ring, to `out`.
+ * Normal context only, and from one thread at a time.  Returns how many
+ * were appended.
+ */
+std::size_t fault_ring_drain(std::vector<FaultRecord>& out);
+
+/** Faults that could not be recorded (no ring, or ring full). */
+std::uint64_t fault_ring_dropped();
+#endif // FAULT_RING_H
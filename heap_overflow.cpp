@@ -1,4 +1,7 @@
 #include "heap_overflow.h"
+#include "crash_guard.h"
+#include "trial_trace.h"
+#include <algorithm>
 #include <iostream>
 #include <cstdlib>
 #include <cstring>
@@ -13,6 +16,34 @@
 #  include <cstdio>
 #endif
 
+// Region of the run in flight; still set if the overrun faulted out of it
+static void*  LIVE_REGION     = nullptr;
+static size_t LIVE_REGION_LEN = 0;
+
+static HeapOverflowProfile PROFILE;
+
+const HeapOverflowProfile& last_heap_overflow_profile() { return PROFILE; }
+
+static void unmap_region(void* region, size_t len)
+{
+#ifdef _WIN32
+    (void)len;
+    VirtualFree(region, 0, MEM_RELEASE);
+#else
+    munmap(region, len);
+#endif
+}
+
+void release_heap_overflow_region()
+{
+    if (!LIVE_REGION)
+        return;
+    trace_begin(TracePhase::Cleanup);
+    unmap_region(LIVE_REGION, LIVE_REGION_LEN);
+    LIVE_REGION = nullptr;
+    trace_end(TracePhase::Cleanup);
+}
+
 void run_heap_overflow(std::size_t alloc_sz,
                        std::size_t overrun_sz,
                        bool verbose)
@@ -31,6 +62,7 @@ void run_heap_overflow(std::size_t alloc_sz,
 
     size_t rounded = ((alloc_sz + page - 1) / page) * page;
 
+    trace_begin(TracePhase::Mmap);
 #ifdef _WIN32
     void* region = VirtualAlloc(nullptr,
                                 rounded + page,
@@ -40,6 +72,8 @@ void run_heap_overflow(std::size_t alloc_sz,
         std::cerr << "VirtualAlloc failed: " << GetLastError() << std::endl;
         std::exit(EXIT_FAILURE);
     }
+    trace_end(TracePhase::Mmap);
+    trace_begin(TracePhase::Mprotect);
     DWORD old;
     if (!VirtualProtect(static_cast<char*>(region) + rounded,
                         page,
@@ -60,6 +94,8 @@ void run_heap_overflow(std::size_t alloc_sz,
         perror("mmap");
         std::exit(EXIT_FAILURE);
     }
+    trace_end(TracePhase::Mmap);
+    trace_begin(TracePhase::Mprotect);
     if (mprotect(static_cast<char*>(region) + rounded,
                  page,
                  PROT_NONE) != 0)
@@ -69,19 +105,45 @@ void run_heap_overflow(std::size_t alloc_sz,
         std::exit(EXIT_FAILURE);
     }
 #endif
+    trace_end(TracePhase::Mprotect);
+
+    LIVE_REGION     = region;
+    LIVE_REGION_LEN = rounded + page;
 
     char* buf = static_cast<char*>(region);
 
+    trace_begin(TracePhase::Memset);
     std::memset(buf, 0, alloc_sz);
+    trace_end(TracePhase::Memset);
 
-    for (size_t i = 0; i < overrun_sz; ++i)
-        buf[alloc_sz + i] = 'X'; 
+    // The slack up to the guard page is writable; the first store past
+    // `rounded` is the one that traps, so the loop is split right there
+    const size_t slack = std::min(overrun_sz, rounded - alloc_sz);
 
-#ifdef _WIN32
-    VirtualFree(region, 0, MEM_RELEASE);
-#else
-    munmap(region, rounded + page);
-#endif
+    PROFILE = HeapOverflowProfile{};
+    PROFILE.base  = reinterpret_cast<std::uintptr_t>(region);
+    PROFILE.alloc = alloc_sz;
+    PROFILE.slack = slack;
+
+    trace_begin(TracePhase::Overrun);
+    const long long fill_start = guard_clock_ns();
+    for (size_t i = 0; i < slack; ++i)
+        buf[alloc_sz + i] = 'X';
+    PROFILE.fill_end_ns = guard_clock_ns();
+    PROFILE.fill_ns     = PROFILE.fill_end_ns - fill_start;
+    trace_end(TracePhase::Overrun);
+
+    if (slack < overrun_sz) {
+        trace_begin(TracePhase::TrapEntry);
+        for (size_t i = slack; i < overrun_sz; ++i)
+            buf[alloc_sz + i] = 'X';
+        trace_end(TracePhase::TrapEntry);
+    }
+
+    trace_begin(TracePhase::Cleanup);
+    unmap_region(region, rounded + page);
+    LIVE_REGION = nullptr;
+    trace_end(TracePhase::Cleanup);
 
     std::cout << "[heap_overflow] Memory write completed. Guard page triggered." << '\n';
 }
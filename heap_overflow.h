@@ -2,8 +2,23 @@
 #define HEAP_OVERFLOW_H
 
 #include <cstddef>     // std::size_t
+#include <cstdint>     // std::uintptr_t
 #include <string_view>
 
+/**
+ * What the last `run_heap_overflow` call did up to the faulting store.
+ * The slack between `alloc` and the guard page is plain writable memory,
+ * so the time to fault is page‑fill bandwidth plus a fixed trap cost;
+ * this lets the two be separated.
+ */
+struct HeapOverflowProfile {
+    std::uintptr_t base        = 0;  // start of the mapped region
+    std::size_t    alloc       = 0;  // requested allocation size
+    std::size_t    slack       = 0;  // bytes written before the guard page
+    long long      fill_ns     = 0;  // time spent writing the slack
+    long long      fill_end_ns = 0;  // guard_clock_ns() right before the trapping store
+};
+
 /**
  * Allocates `alloc_sz` bytes on the heap, initialises them to zero,
  * then deliberately walks `overrun_sz` bytes beyond the allocation.
@@ -16,6 +31,16 @@ void run_heap_overflow(std::size_t alloc_sz,
                        std::size_t overrun_sz,
                        bool verbose = true);
 
+/** Profile of the most recent run (valid after it faulted, too). */
+const HeapOverflowProfile& last_heap_overflow_profile();
+
+/**
+ * Unmaps the region of a run that was cut short by the guard‑page fault
+ * (the fault longjmps out before `run_heap_overflow` can clean up).
+ * No‑op if the last run finished normally.
+ */
+void release_heap_overflow_region();
+
 /** Command‑line helper: recognises options that belong to this test. */
 void print_heap_overflow_help(std::string_view program);
 #endif // HEAP_OVERFLOW_H
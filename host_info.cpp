@@ -0,0 +1,167 @@
+#include "host_info.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#if defined(_WIN32)
+#  include <windows.h>
+#else
+#  include <sys/utsname.h>
+#  include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#  include <dirent.h>
+#endif
+
+namespace {
+
+// First line of a small /proc or /sys file, "" if it can't be read
+std::string read_line(const std::string& path)
+{
+    std::ifstream in(path);
+    std::string line;
+    std::getline(in, line);
+    return line;
+}
+
+// Value of the first "key<TAB>: value" line in /proc/cpuinfo
+std::string cpuinfo_field(const std::string& text, const std::string& key)
+{
+    std::istringstream in(text);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.compare(0, key.size(), key) != 0) continue;
+        const auto colon = line.find(':');
+        if (colon == std::string::npos) continue;
+        const auto first = line.find_first_not_of(" \t", colon + 1);
+        return first == std::string::npos ? "" : line.substr(first);
+    }
+    return "";
+}
+
+// Boot parameters that change fault or TLB cost; the rest (BOOT_IMAGE=,
+// root=UUID=, console=, init arguments after "--") differ from host to host
+// without meaning anything for the numbers
+bool perf_relevant_param(const std::string& key)
+{
+    static const char* const exact[] = {
+        "mitigations", "pti", "nopti", "kpti", "nospectre_v1", "nospectre_v2", "spectre_v2",
+        "spectre_v2_user", "spectre_bhi", "spec_store_bypass_disable", "ssbd", "l1tf", "mds",
+        "tsx", "tsx_async_abort", "mmio_stale_data", "retbleed", "srbds", "gather_data_sampling",
+        "reg_file_data_sampling", "spec_rstack_overflow", "nosmt", "nopcid", "noinvpcid",
+        "nokaslr", "kaslr", "randomize_kstack_offset", "init_on_alloc", "init_on_free",
+        "page_alloc.shuffle", "transparent_hugepage", "hugepages", "hugepagesz",
+        "default_hugepagesz", "numa_balancing", "isolcpus", "nohz_full", "nohz", "rcu_nocbs",
+        "irqaffinity", "idle", "intel_idle.max_cstate", "processor.max_cstate", "intel_pstate",
+        "amd_pstate", "preempt", "threadirqs", "nowatchdog", "nmi_watchdog", "audit",
+    };
+    for (const char* e : exact)
+        if (key == e) return true;
+    return false;
+}
+
+// "kernel.cmdline" reduced to its performance-relevant parameters, in boot order
+std::string normalise_cmdline(const std::string& cmdline)
+{
+    std::istringstream in(cmdline);
+    std::string tok, out;
+    while (in >> tok && tok != "--") {
+        if (!perf_relevant_param(tok.substr(0, tok.find('=')))) continue;
+        if (!out.empty()) out += ' ';
+        out += tok;
+    }
+    return out;
+}
+
+} // namespace
+
+std::string HostFingerprint::config_hash() const
+{
+    std::uint64_t h = 0xcbf29ce484222325ULL;
+    auto mix = [&](const std::string& s) {
+        for (unsigned char c : s) { h ^= c; h *= 0x100000001b3ULL; }
+        h ^= 0xff; h *= 0x100000001b3ULL;       // field separator
+    };
+    for (const auto& [k, v] : fields) {
+        // os.version is the kernel's build stamp; os.release names the kernel
+        if (k == "host.name" || k == "cpu.mhz" || k == "os.version") continue;
+        mix(k);
+        mix(k == "kernel.cmdline" ? normalise_cmdline(v) : v);
+    }
+    char buf[17];
+    std::snprintf(buf, sizeof(buf), "%016llx", static_cast<unsigned long long>(h));
+    return buf;
+}
+
+HostFingerprint collect_host_fingerprint()
+{
+    HostFingerprint fp;
+    auto add = [&](const std::string& k, const std::string& v) {
+        if (!v.empty()) fp.fields.emplace_back(k, v);
+    };
+
+#if defined(_WIN32)
+    add("os.name", "Windows");
+    char name[256]; DWORD len = sizeof(name);
+    if (GetComputerNameA(name, &len)) add("host.name", std::string(name, len));
+#else
+    utsname u{};
+    if (uname(&u) == 0) {
+        add("os.name",    u.sysname);
+        add("os.release", u.release);
+        add("os.version", u.version);
+        add("os.machine", u.machine);
+        add("host.name",  u.nodename);
+    }
+#endif
+    add("cpu.count", std::to_string(std::thread::hardware_concurrency()));
+
+#if defined(__linux__)
+    add("kernel.cmdline", read_line("/proc/cmdline"));
+
+    std::ifstream ci("/proc/cpuinfo");
+    std::stringstream text;
+    text << ci.rdbuf();
+    const std::string cpuinfo = text.str();
+    std::string model = cpuinfo_field(cpuinfo, "model name");
+    if (model.empty()) model = cpuinfo_field(cpuinfo, "CPU part");   // arm64
+    add("cpu.model",     model);
+    add("cpu.microcode", cpuinfo_field(cpuinfo, "microcode"));
+    add("cpu.mhz",       cpuinfo_field(cpuinfo, "cpu MHz"));
+
+    // One entry per mitigation; "meltdown" carries the PTI state on x86
+    const std::string vuln_dir = "/sys/devices/system/cpu/vulnerabilities";
+    if (DIR* d = opendir(vuln_dir.c_str())) {
+        std::vector<std::string> names;
+        while (dirent* e = readdir(d))
+            if (e->d_name[0] != '.') names.emplace_back(e->d_name);
+        closedir(d);
+        std::sort(names.begin(), names.end());
+        for (const auto& n : names)
+            add("vuln." + n, read_line(vuln_dir + "/" + n));
+    }
+
+    const std::string thp = "/sys/kernel/mm/transparent_hugepage/";
+    add("thp.enabled", read_line(thp + "enabled"));
+    add("thp.defrag",  read_line(thp + "defrag"));
+
+    const std::string freq = "/sys/devices/system/cpu/cpu0/cpufreq/";
+    add("cpufreq.driver",   read_line(freq + "scaling_driver"));
+    add("cpufreq.governor", read_line(freq + "scaling_governor"));
+    add("cpufreq.epp",      read_line(freq + "energy_performance_preference"));
+    add("cpufreq.no_turbo", read_line("/sys/devices/system/cpu/intel_pstate/no_turbo"));
+    add("cpufreq.boost",    read_line("/sys/devices/system/cpu/cpufreq/boost"));
+#endif
+    return fp;
+}
+
+void write_fingerprint_header(std::ostream& os, const HostFingerprint& fp)
+{
+    os << "# config_hash: " << fp.config_hash() << '\n';
+    for (const auto& [k, v] : fp.fields)
+        os << "# " << k << ": " << v << '\n';
+}
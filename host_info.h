@@ -0,0 +1,37 @@
+#ifndef HOST_INFO_H
+#define HOST_INFO_H
+
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Everything about the host that moves fault latency: kernel release and
+ * command line, CPU model / microcode, PTI and the other vulnerability
+ * mitigations, THP mode and the cpufreq governor.  Keys are stable and
+ * dotted (e.g. "vuln.meltdown", "thp.enabled") so result sets from
+ * differently configured nodes can be grouped by them.
+ */
+struct HostFingerprint {
+    std::vector<std::pair<std::string, std::string>> fields;
+
+    /**
+     * FNV-1a over every field except the per-host ones (hostname, clock
+     * speed, kernel build stamp), as 16 hex digits.  Only the boot
+     * parameters that affect the measurement (mitigations, THP, isolcpus,
+     * ...) enter from the kernel command line.  Identically configured
+     * nodes share it.
+     */
+    std::string config_hash() const;
+};
+
+/** Reads uname, /proc and /sys once; unreadable sources are skipped. */
+HostFingerprint collect_host_fingerprint();
+
+/**
+ * Writes the fingerprint as "# key: value" lines, i.e. a comment header
+ * that CSV readers skip (pandas: `comment='#'`).
+ */
+void write_fingerprint_header(std::ostream& os, const HostFingerprint& fp);
+#endif // HOST_INFO_H
@@ -0,0 +1,99 @@
+#include "interference.h"
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#if defined(__linux__)
+#  include <sched.h>
+#  include <sys/resource.h>
+#elif !defined(_WIN32)
+#  include <sys/resource.h>
+#endif
+
+namespace {
+
+#if defined(__linux__)
+// Sums the /proc/interrupts column that belongs to `cpu`.  Offline CPUs
+// have no column, so the header is searched for "CPU<n>" explicitly.
+long long read_cpu_irqs(int cpu)
+{
+    std::ifstream in("/proc/interrupts");
+    std::string line;
+    if (cpu < 0 || !in || !std::getline(in, line))
+        return -1;
+
+    const std::string want = "CPU" + std::to_string(cpu);
+    std::istringstream hdr(line);
+    std::string tok;
+    int col = 0, ncols = 0, idx = -1;
+    while (hdr >> tok) {
+        if (tok == want) idx = col;
+        ++col;
+    }
+    ncols = col;
+    if (idx < 0)
+        return -1;
+
+    long long total = 0;
+    while (std::getline(in, line)) {
+        std::istringstream row(line);
+        row >> tok;                        // "NMI:", "LOC:", "24:" ...
+        if (tok == "ERR:" || tok == "MIS:")
+            continue;                      // one global value, not per CPU
+        long long v = 0;
+        int n = 0;
+        for (; n < ncols && (row >> v); ++n)
+            if (n == idx) total += v;
+    }
+    return total;
+}
+#endif
+
+} // namespace
+
+InterferenceSnapshot take_interference_snapshot()
+{
+    InterferenceSnapshot s;
+#if defined(__linux__)
+    s.cpu  = sched_getcpu();
+    s.irqs = read_cpu_irqs(s.cpu);
+
+    rusage ru{};
+    if (getrusage(RUSAGE_THREAD, &ru) == 0) {
+        s.vol_csw   = ru.ru_nvcsw;
+        s.invol_csw = ru.ru_nivcsw;
+    }
+#elif !defined(_WIN32)
+    rusage ru{};
+    if (getrusage(RUSAGE_SELF, &ru) == 0) {
+        s.vol_csw   = ru.ru_nvcsw;
+        s.invol_csw = ru.ru_nivcsw;
+    }
+#endif
+    return s;
+}
+
+Interference interference_between(const InterferenceSnapshot& before,
+                                  const InterferenceSnapshot& after)
+{
+    Interference d;
+    d.vol_csw   = after.vol_csw   - before.vol_csw;
+    d.invol_csw = after.invol_csw - before.invol_csw;
+    d.migrated  = before.cpu != after.cpu;
+    if (!d.migrated && before.irqs >= 0 && after.irqs >= 0)
+        d.irqs = after.irqs - before.irqs;
+    return d;
+}
+
+bool pin_to_cpu(int cpu)
+{
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
@@ -0,0 +1,43 @@
+#ifndef INTERFERENCE_H
+#define INTERFERENCE_H
+
+/**
+ * Scheduler / interrupt activity observed around one timed trial.
+ *
+ * A snapshot is taken right before the timer starts and right after it
+ * stops; the difference tells whether the trial was preempted, migrated
+ * to another CPU or had an interrupt land on its CPU.  Such trials
+ * measure scheduler noise rather than the fault path.
+ */
+struct InterferenceSnapshot {
+    long      vol_csw   = 0;    // voluntary context switches so far
+    long      invol_csw = 0;    // involuntary context switches so far
+    int       cpu       = -1;   // CPU we were running on (-1 = unknown)
+    long long irqs      = -1;   // interrupts serviced by `cpu` (-1 = unreadable)
+};
+
+struct Interference {
+    long      vol_csw   = 0;    // voluntary switches inside the window
+    long      invol_csw = 0;    // involuntary switches inside the window
+    bool      migrated  = false;
+    long long irqs      = -1;   // interrupt delta on the start CPU (-1 = unknown)
+
+    bool disturbed() const
+    {
+        return vol_csw > 0 || invol_csw > 0 || migrated || irqs > 0;
+    }
+};
+
+/** Samples context-switch counters, current CPU and its interrupt count. */
+InterferenceSnapshot take_interference_snapshot();
+
+/** Difference between two snapshots taken around the same trial. */
+Interference interference_between(const InterferenceSnapshot& before,
+                                  const InterferenceSnapshot& after);
+
+/**
+ * Pins the calling thread to `cpu` so migration and per-CPU interrupt
+ * counts are meaningful.  Returns false if the platform refuses.
+ */
+bool pin_to_cpu(int cpu);
+#endif // INTERFERENCE_H
@@ -26,6 +26,7 @@
 
 // Since the order of these #includes doesn't matter,
 // they're sorted in descending length for aesthetics
+#include <condition_variable>
 #include <unordered_map>
 #include <unordered_set>
 #include <forward_list>
@@ -36,27 +37,50 @@
 #include <algorithm>
 #include <stdexcept>
 #include <optional>
+#include <charconv>
 #include <iostream>
 #include <iterator>
 #include <fstream>
+#include <numeric>
 #include <sstream>
 #include <ostream>
 #include <utility>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
 #include <string>
 #include <vector>
+#include <memory>
+#include <cerrno>
+#include <thread>
+#include <future>
 #include <random>
 #include <chrono>
 #include <atomic>
+#include <limits>
+#include <cctype>
 #include <regex>
+#include <mutex>
 #include <array>
 #include <deque>
 #include <ctime>
+#include <cmath>
 #include <queue>
 #include <stack>
 #include <list>
 #include <set>
 #include <map>
 
+#if defined(__unix__) || defined(__APPLE__)
+#   define ZEN_HAS_MMAP  1
+#   define ZEN_HAS_POSIX 1
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <signal.h>
+#   include <fcntl.h>
+#   include <unistd.h>
+#endif
+
 namespace zen {
 
 ///////////////////////////////////////////////////////////////////////////////////////////// MISC
@@ -382,6 +406,7 @@ private:
 // zen::cloc cloc(zen::parent_path(), { "datas", "functions", "tests" });
 // cloc.count({    ".h",     ".cpp",     ".py" });
 // cloc.count({ R"(\.h)", R"(\.cpp)", R"(\.py)" };
+// cloc.count({ ".h", ".cpp" }, 8); // same count on 8 threads
 // 
 // Name is based on the popular utility cloc: https://github.com/AlDanial/cloc
 class cloc {
@@ -396,27 +421,27 @@ public:
 
     cloc(const std::filesystem::path& root, const std::vector<std::string>& dirs) 
         : root_(root), dirs_(dirs) {}
+
+    // Keeps each file's LOC in `file` between runs, keyed by path, size,
+    // mtime and inode, so later counts only rescan files that changed.  A
+    // directory whose mtime and inode are unchanged is not listed again:
+    // its entries come from the cache and are only stat'ed.
+    cloc& cache(const std::filesystem::path& file) { cache_ = file; return *this; }
  
-    // TODO:LATER: This will run cloc on multiple threads, but will require linking with a
-    // threading library. Seems to not be worth the cost just for this one. Maybe if
-    // there's a more compelling reason to make Kaizen require multithreading.
-    // Used like this to run on 10 threads:
+    // Runs the parallel count below on a separate thread, e.g. 10 counts at once:
     // 
     // zen::cloc cloc;
+    // std::vector<std::future<int>> counts;
     // for (int i : zen::in(10))
-    //    zen::log(cloc.count_async({ ".h" }).get());
+    //    counts.push_back(cloc.count_async({ ".h" }));
     // 
-    //std::future<int> count_async(const std::vector<std::string>& extensions) const {
-    //    std::promise<int> prom;
-    //    std::future<int> fut = prom.get_future();
-    //    std::jthread t([this, extensions, prom = std::move(prom)]() mutable
-    //                   {
-    //                       prom.set_value(count(extensions));
-    //                   });
-    //    return fut;
-    //}
+    std::future<int> count_async(const std::vector<std::string>& extensions, unsigned threads = 0) const {
+        return std::async(std::launch::async, [this, extensions, threads] { return count(extensions, threads); });
+    }
 
     int count(const std::vector<std::string>& extensions) const {
+        if (!cache_.empty())
+            return count_cached(extensions, 1);
         int total_loc = 0;
         for (const auto& dir : dirs_) {
             total_loc += count_in(root_ / dir, extensions);
@@ -424,12 +449,30 @@ public:
         return total_loc;
     }
 
+    // Same count with the files spread over `threads` workers (0 = one per core)
+    int count(const std::vector<std::string>& extensions, unsigned threads) const {
+        if (!cache_.empty())
+            return count_cached(extensions, threads);
+        const matcher match(extensions);
+        std::vector<std::filesystem::path> files;
+        for (const auto& dir : dirs_)
+            for (const auto& file : std::filesystem::recursive_directory_iterator(root_ / dir))
+                if (file.is_regular_file() && match(file.path().extension().string()))
+                    files.push_back(file.path());
+
+        int total = 0;
+        for (int loc : count_files(files, threads))
+            total += loc;
+        return total;
+    }
+
     int count_in(const std::filesystem::path& dir, const std::vector<std::string>& extensions) const {
+        const matcher match(extensions);
         int dir_loc = 0;
         for (const auto& file : std::filesystem::recursive_directory_iterator(dir)) {
             if (file.is_regular_file()) {
                 const std::string ext = file.path().extension().string();
-                if (matches_any(ext, extensions)) {
+                if (match(ext)) {
                     [[maybe_unused]] int loc = dir_loc += count_in_file(file.path());
                     //std::cout << "LOC" << std::setw(5) << loc << " - " << file.path().string() << std::endl; // DEBUG
                 }
@@ -438,31 +481,276 @@ public:
         return dir_loc;
     }
 
+    // Maps the file (or reads it where there is no mmap) and finds line
+    // ends with memchr, which libc vectorizes
     int count_in_file(const std::filesystem::path& filename) const {
-        std::ifstream file(filename.string());
-        std::string line;
         int loc = 0;
-        while (std::getline(file, line)) {
-            if (std::regex_match(line, std::regex(R"(^\s*[^/\*\\].*\r?$)"))) {
-                ++loc;
+        auto count_lines = [&loc](const char* p, const char* end) {
+            while (p < end) {
+                const char* nl = static_cast<const char*>(std::memchr(p, '\n', static_cast<std::size_t>(end - p)));
+                const char* eol = nl ? nl : end;
+                loc += is_code_line(std::string_view(p, static_cast<std::size_t>(eol - p)));
+                p = eol + 1;
+            }
+        };
+#if ZEN_HAS_MMAP
+        const int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0)
+            return 0;
+        struct stat st {};
+        if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+            const auto len = static_cast<std::size_t>(st.st_size);
+            void* m = ::mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (m != MAP_FAILED) {
+                ::madvise(m, len, MADV_SEQUENTIAL);
+                count_lines(static_cast<const char*>(m), static_cast<const char*>(m) + len);
+                ::munmap(m, len);
+                ::close(fd);
+                return loc;
             }
         }
+        ::close(fd);
+#endif
+        std::ifstream file(filename, std::ios::binary);
+        const std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        count_lines(text.data(), text.data() + text.size());
         return loc;
     }
 
+    // The counting rule, unchanged: what std::regex_match(line, R"(^\s*[^/\*\\].*\r?$)")
+    // says for a line without its '\n'.  `\s*` may give back whitespace,
+    // so any indented line counts; otherwise the first character must not
+    // be '/', '*' or '\\'.  `.` stops at '\r', so a '\r' is only allowed
+    // at the very end or inside the leading whitespace.
+    static bool is_code_line(std::string_view line) {
+        if (line.empty())
+            return false;
+        const auto is_space = [](char c) { return c == ' ' || (c >= '\t' && c <= '\r'); };
+        std::size_t ws = 0;
+        while (ws < line.size() && is_space(line[ws]))
+            ++ws;
+        // The matched character has to come at or after the last inner '\r'
+        const std::string_view body = line.substr(0, line.size() - 1);
+        const std::size_t cr = body.rfind('\r');
+        const std::size_t lo = cr == std::string_view::npos ? 0 : cr;
+        const std::size_t hi = std::min(ws, line.size() - 1);
+        if (lo > hi)
+            return false;
+        if (lo < ws)
+            return true;
+        const char c = line[ws];
+        return c != '/' && c != '*' && c != '\\';
+    }
+
 private:
-    bool matches_any(const std::string& ext, const std::vector<std::string>& extensions) const {
-        for (const auto& pattern : extensions) {
-            if (std::regex_match(ext, std::regex(pattern))) {
+    // The extensions, compiled once: plain ones (".h", R"(\.h)") go into a
+    // hash set, anything else stays a regex
+    class matcher {
+    public:
+        explicit matcher(const std::vector<std::string>& patterns) {
+            for (const auto& p : patterns) {
+                std::string lit;
+                if (as_literal(p, lit))
+                    literals_.insert(lit);
+                else
+                    regexes_.emplace_back(p);
+            }
+        }
+
+        bool operator()(const std::string& ext) const {
+            if (literals_.count(ext))
                 return true;
+            for (const auto& re : regexes_)
+                if (std::regex_match(ext, re))
+                    return true;
+            return false;
+        }
+
+    private:
+        // An unescaped '.' is only literal in front: extensions always start with one
+        static bool as_literal(const std::string& p, std::string& out) {
+            for (std::size_t i = 0; i < p.size(); ++i) {
+                const char c = p[i];
+                if (c == '\\' && i + 1 < p.size() && p[i + 1] == '.') { out += '.'; ++i; continue; }
+                if (c == '.' && i == 0) { out += '.'; continue; }
+                if (c == '\0' || std::strchr("^$\\.|?*+()[]{}", c))
+                    return false;
+                out += c;
             }
+            return true;
         }
-        return false;
+
+        std::unordered_set<std::string> literals_;
+        std::vector<std::regex>         regexes_;
+    };
+
+    // LOC of every file, spread over `threads` workers (0 = one per core)
+    std::vector<int> count_files(const std::vector<std::filesystem::path>& files, unsigned threads) const {
+        if (threads == 0)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        threads = static_cast<unsigned>(std::min<std::size_t>(threads, std::max<std::size_t>(files.size(), 1)));
+
+        std::vector<int>         locs(files.size());
+        std::atomic<std::size_t> next{ 0 };
+        auto worker = [&] {
+            for (std::size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < files.size();)
+                locs[i] = count_in_file(files[i]);
+        };
+        std::vector<std::thread> pool;
+        for (unsigned t = 1; t < threads; ++t)
+            pool.emplace_back(worker);
+        worker();
+        for (auto& t : pool)
+            t.join();
+        return locs;
+    }
+
+    // One line per path: "<kind> <size> <mtime> <inode> <loc> <path>", kind
+    // 'd' (directory), 'f' (regular file, loc -1 = never counted) or 'o'
+    struct cache_entry {
+        char          kind  = 'o';
+        std::uintmax_t size  = 0;
+        long long     mtime = 0;
+        std::uintmax_t inode = 0;
+        int           loc   = -1;
+
+        bool same_file(const cache_entry& e) const { return size == e.size && mtime == e.mtime && inode == e.inode; }
+    };
+    using cache_map = std::map<std::string, cache_entry>;   // sorted, so a directory's entries are adjacent
+
+    static cache_entry stat_entry(const std::filesystem::path& p, char kind) {
+        cache_entry e;
+        e.kind = kind;
+        std::error_code ec;
+        e.mtime = static_cast<long long>(std::filesystem::last_write_time(p, ec).time_since_epoch().count());
+#if ZEN_HAS_MMAP
+        struct stat st {};
+        if (::stat(p.c_str(), &st) == 0) {
+            e.inode = static_cast<std::uintmax_t>(st.st_ino);
+            e.size  = kind == 'f' ? static_cast<std::uintmax_t>(st.st_size) : 0;
+        }
+#else
+        if (kind == 'f')
+            e.size = std::filesystem::file_size(p, ec);
+#endif
+        return e;
+    }
+
+    cache_map load_cache() const {
+        cache_map m;
+        std::ifstream in(cache_);
+        std::string line;
+        if (!std::getline(in, line) || line != "zen::cloc cache 1")
+            return m;
+        while (std::getline(in, line)) {
+            std::istringstream ss(line);
+            cache_entry e;
+            std::string path;
+            if (ss >> e.kind >> e.size >> e.mtime >> e.inode >> e.loc && ss.get() == ' ' && std::getline(ss, path))
+                m[path] = e;
+        }
+        return m;
+    }
+
+    void save_cache(const cache_map& m) const {
+        // Concurrent counts (count_async) may share the cache: each writes
+        // its own temporary, and the last rename wins with a whole cache
+        static std::atomic<unsigned> serial{ 0 };
+        std::ostringstream name;
+        name << cache_.string() << '.' << std::this_thread::get_id() << '.' << serial.fetch_add(1);
+#if ZEN_HAS_POSIX
+        name << '.' << ::getpid();
+#endif
+        const std::filesystem::path tmp = name.str() + ".tmp";
+        std::error_code ec;
+        {
+            std::ofstream out(tmp);
+            out << "zen::cloc cache 1\n";
+            for (const auto& [path, e] : m)
+                out << e.kind << ' ' << e.size << ' ' << e.mtime << ' ' << e.inode << ' ' << e.loc << ' ' << path << '\n';
+            if (!out) {
+                out.close();
+                std::filesystem::remove(tmp, ec);
+                return;
+            }
+        }
+        std::filesystem::rename(tmp, cache_, ec);     // readers never see half a cache
+        if (ec)
+            std::filesystem::remove(tmp, ec);
+    }
+
+    // Same traversal as recursive_directory_iterator (symlinked directories
+    // are not entered), listing only directories that changed
+    void walk(const std::filesystem::path& dir, const cache_map& old, cache_map& now,
+              const matcher& match, std::vector<std::string>& counted) const {
+        const std::string d  = dir.generic_string();
+        const cache_entry de = stat_entry(dir, 'd');
+        const auto        it = old.find(d);
+        now[d] = de;
+
+        std::vector<std::pair<std::string, char>> children;
+        if (it != old.end() && it->second.kind == 'd' && it->second.same_file(de)) {
+            const std::string prefix = !d.empty() && d.back() == '/' ? d : d + '/';   // "/" stays "/"
+            for (auto c = old.lower_bound(prefix); c != old.end() && c->first.compare(0, prefix.size(), prefix) == 0; ++c)
+                if (c->first.find('/', prefix.size()) == std::string::npos)
+                    children.emplace_back(c->first, c->second.kind);
+        } else {
+            for (const auto& e : std::filesystem::directory_iterator(dir)) {
+                const char kind = e.is_directory() && !e.is_symlink() ? 'd' : e.is_regular_file() ? 'f' : 'o';
+                children.emplace_back(e.path().generic_string(), kind);
+            }
+        }
+
+        for (const auto& [path, kind] : children) {
+            if (kind == 'd') {
+                walk(path, old, now, match, counted);
+                continue;
+            }
+            const auto prev = old.find(path);
+            if (kind == 'o' || !match(std::filesystem::path(path).extension().string())) {
+                now[path] = prev != old.end() ? prev->second : cache_entry{ kind };   // kept for other extensions
+                continue;
+            }
+            cache_entry e = stat_entry(path, 'f');
+            if (prev != old.end() && prev->second.kind == 'f' && prev->second.same_file(e))
+                e.loc = prev->second.loc;                 // -1 if it was never counted
+            now[path] = e;
+            counted.push_back(path);
+        }
+    }
+
+    int count_cached(const std::vector<std::string>& extensions, unsigned threads) const {
+        const matcher match(extensions);
+        const cache_map old = load_cache();
+        cache_map now;
+        std::vector<std::string> counted;
+        for (const auto& dir : dirs_) {
+            // One spelling per directory: "src/", "src/." and "./src" must key the same entries
+            std::filesystem::path p = (root_ / dir).lexically_normal();
+            if (!p.has_filename() && p != p.root_path())
+                p = p.parent_path();
+            walk(p, old, now, match, counted);
+        }
+
+        std::vector<std::filesystem::path> stale;
+        for (const auto& path : counted)
+            if (now[path].loc < 0)
+                stale.push_back(path);
+        const std::vector<int> locs = count_files(stale, threads);
+        for (std::size_t i = 0; i < stale.size(); ++i)
+            now[stale[i].generic_string()].loc = locs[i];
+
+        int total = 0;
+        for (const auto& path : counted)
+            total += now[path].loc;
+        save_cache(now);
+        return total;
     }
 
 private:
-	std::filesystem::path	 root_; // project root
-	std::vector<std::string> dirs_; // where to count
+	std::filesystem::path	 root_;  // project root
+	std::vector<std::string> dirs_;  // where to count
+	std::filesystem::path	 cache_; // per-file LOC between runs ("" = none)
 };
 
 ///////////////////////////////////////////////////////////////////////////////////////////// zen::cmd_args
@@ -473,9 +761,11 @@ private:
 // zen::cmd_args        cmd_args(argv, argc);
 // const bool verbose = cmd_args.accept("-verbose").is_present();
 // const bool ignore  = cmd_args.accept("-ignore" ).is_present();
-
-// TODO: Enhance with support for:
-// - Help strings
+// const auto size    = cmd_args.accept("--size", "BYTES", "block size").get<std::size_t>("--size", 4096); // "1M" works
+// std::cout << cmd_args.help();   // every argument accepted with a description
+//
+// argv is indexed once on construction, so lookups are O(1) however long
+// the command line; values are string_views into argv, not copies.
 class cmd_args {
 public:
     cmd_args() : argv_(nullptr), argc_(0) {}
@@ -493,6 +783,9 @@ public:
                 throw std::invalid_argument("CONSTRUCTOR ARGUMENT argv CONTAINS nullptr ELEMENT(S)");
             }
         }
+        index_.reserve(static_cast<std::size_t>(argc));
+        for (int i = 0; i < argc; ++i)
+            index_.emplace(argv[i], i); // the first occurrence wins, as with a scan
     }
 
     auto& accept(const std::string& arg)
@@ -507,48 +800,112 @@ public:
         return *this;
     }
 
+    // Same, with a line for help(); `value` names what follows arg ("N", "FILE"), if anything
+    auto& accept(const std::string& arg, const std::string& value, const std::string& description)
+    {
+        accept(arg);
+        if (!arg.empty())
+            described_.push_back({ arg, value, description });
+        return *this;
+    }
+
     // Returns true if either the provided argument 'a' or the last argument added by accept()
     // is present in the command line (with which the program was presumably launched)
-    bool is_present(const std::string& arg = "") const
+    bool is_present(std::string_view arg = "") const
     {
         if (arg.empty())
             return args_accepted_.empty() ? false : is_present(args_accepted_.back());
 
-        for (int i = 0; i < argc_; ++i)
-            if (arg == arg_at(i))
-                return true;
+        return index_.count(arg) != 0;
+    }
 
-        return false;
+    // All non-dashed strings that follow arg, as views into argv
+    // Example: --copy from/some/dir to/some/dir -verbose
+    //                 ^^^^^^^^^^^^^ ^^^^^^^^^^^
+    std::vector<std::string_view> options(std::string_view arg) const
+    {
+        std::vector<std::string_view> opts;
+        for (int i = find(arg) + 1; i < argc_; ++i) {
+            const std::string_view ai = view_at(i);
+            if (!ai.empty() && ai[0] == '-')
+                break; // stop collecting when a new dashed argument is encountered
+
+            opts.push_back(ai);
+        }
+        return opts;
     }
 
-    auto get_options(const std::string& arg) const
+    auto get_options(std::string_view arg) const
     {
-        std::vector<std::string> options;
+        std::vector<std::string> opts;
+        for (const auto& o : options(arg))
+            opts.emplace_back(o);
+        return opts; // empty if arg is absent
+    }
 
-        int idx = find(arg);
+    // The value after arg as a T, or `fallback` if arg is absent.  Integers
+    // may be hex ("0x1f") and carry a binary size suffix ("64K", "1M", "2GiB").
+    template<class T>
+    T get(std::string_view arg, T fallback = T{}) const
+    {
+        const int idx = find(arg);
         if (idx >= argc_)
-            return options; // as empty
+            return fallback;
 
-        // Collect all non-dashed strings that follow arg as its options
-        // Example: --copy from/some/dir to/some/dir -verbose
-        //                 ^^^^^^^^^^^^^ ^^^^^^^^^^^
-        for (int i = idx + 1; i < argc_; ++i)
-        {
-            const std::string& ai = arg_at(i);
-            if (ai[0] == '-')
-                break; // stop collecting when a new dashed argument is encountered
+        const std::string_view v = view_at(idx + 1);
+        if (idx + 1 >= argc_ || (!v.empty() && v[0] == '-'))
+            throw std::invalid_argument("MISSING VALUE FOR " + zen::quote(std::string(arg)));
+        T out{};
+        if (!parse_value(v, out))
+            throw std::invalid_argument("INVALID VALUE FOR " + zen::quote(std::string(arg)) + ": " + zen::quote(std::string(v)));
+        return out;
+    }
 
-            options.push_back(ai);
-        }
+    // Every value after arg as a T, whether given as "--n 1 2 4" or "--n 1,2,4"
+    template<class T>
+    std::vector<T> get_all(std::string_view arg) const
+    {
+        std::vector<T> out;
+        for (std::string_view o : options(arg))
+            for (std::size_t b = 0; b <= o.size();) {
+                const std::size_t comma = std::min(o.find(',', b), o.size());
+                const std::string_view item = o.substr(b, comma - b);
+                b = comma + 1;
+                if (item.empty())
+                    continue;
+                T v{};
+                if (!parse_value(item, v))
+                    throw std::invalid_argument("INVALID VALUE FOR " + zen::quote(std::string(arg)) + ": " + zen::quote(std::string(item)));
+                out.push_back(std::move(v));
+            }
+        return out;
+    }
 
-        return options;
+    // One aligned line per argument accepted with a description
+    std::string help() const
+    {
+        std::size_t width = 0;
+        for (const auto& d : described_)
+            width = std::max(width, d.arg.size() + (d.value.empty() ? 0 : d.value.size() + 1));
+
+        std::ostringstream os;
+        for (const auto& d : described_) {
+            const std::string lhs = d.value.empty() ? d.arg : d.arg + ' ' + d.value;
+            os << "  " << lhs << std::string(width - lhs.size() + 2, ' ') << d.description << '\n';
+        }
+        return os.str();
     }
 
     std::string arg_at(const int n) const
+    {
+        return std::string(view_at(n));
+    }
+
+    std::string_view view_at(const int n) const
     {
         if (0 <= n && n < argc_)
             return argv_[n];
-        return ""; // signals non-existence
+        return {}; // signals non-existence
     }
 
     std::string first() const { return arg_at(0); }
@@ -556,21 +913,69 @@ public:
 
     std::size_t count_accepted() const { return args_accepted_.size(); }
 
-    int find(const std::string& arg = "") const
+    int find(std::string_view arg = "") const
     {
-        for (int i = 0; i < argc_; ++i)
-            if (arg_at(i) == arg)
-                return i;
-
-        return argc_; // the end, signals 'not found'
+        const auto it = index_.find(arg);
+        return it == index_.end() ? argc_ : it->second; // the end signals 'not found'
     }
 
 private:
     using arguments = std::vector<std::string>;
 
+    struct described {
+        std::string arg, value, description;
+    };
+
+    template<class T>
+    static bool parse_value(std::string_view v, T& out)
+    {
+        if constexpr (std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>) {
+            out = T(v);
+            return true;
+        } else if constexpr (std::is_floating_point_v<T>) {
+            const std::string copy(v);       // strtod: from_chars for floats is not everywhere yet
+            char* stop = nullptr;
+            out = static_cast<T>(std::strtod(copy.c_str(), &stop));
+            return !copy.empty() && stop == copy.c_str() + copy.size();
+        } else {
+            static_assert(std::is_integral_v<T> && !std::is_same_v<T, bool>, "UNSUPPORTED ARGUMENT TYPE");
+            const char* p   = v.data();
+            const char* end = v.data() + v.size();
+            int base = 10;
+            if (v.size() > 2 && p[0] == '0' && (p[1] == 'x' || p[1] == 'X')) {
+                p   += 2;
+                base = 16;
+            }
+            const auto [stop, ec] = std::from_chars(p, end, out, base);
+            if (ec != std::errc() || stop == p)
+                return false;
+
+            std::string_view suffix(stop, static_cast<std::size_t>(end - stop));
+            if (suffix.empty())
+                return true;
+            const std::size_t at = std::string_view("KMGT").find(static_cast<char>(std::toupper(static_cast<unsigned char>(suffix[0]))));
+            suffix.remove_prefix(1);
+            if (at == std::string_view::npos || !(suffix.empty() || suffix == "B" || suffix == "iB"))
+                return false;
+            const unsigned long long scale = 1ULL << (10 * (at + 1));
+            if (scale > static_cast<unsigned long long>(std::numeric_limits<T>::max()))
+                return out == 0;             // overflows T unless zero
+            const T s = static_cast<T>(scale);
+            if (out > std::numeric_limits<T>::max() / s)
+                return false;
+            if constexpr (std::is_signed_v<T>)
+                if (out < std::numeric_limits<T>::min() / s)
+                    return false;
+            out = static_cast<T>(out * s);
+            return true;
+        }
+    }
+
     const char* const* argv_;
     const int          argc_;
     arguments          args_accepted_;
+    std::vector<described>                    described_;
+    std::unordered_map<std::string_view, int> index_;    // argument → first position
 };
 
 ///////////////////////////////////////////////////////////////////////////////////////////// CONCEPTS
@@ -812,26 +1217,593 @@ public:
     auto begin() { return iterator{ *this }; }
     auto end()   { return iterator{ *this, true }; }
 
+    // Line `nth`, counting from 1 like the iterator yields them (a trailing
+    // '\n' is followed by one more, empty, line).  The first call indexes
+    // the file up to that line; after that it is one seek and one read.
+    // Lines already indexed are not looked at again: after writing to the
+    // file (through this object or otherwise) call reindex() first.
     std::string getline(int nth)
     {
-        auto it = begin();
-        while (--nth > 0 && it != end()) {
-            ++it;
-        }
+        if (nth < 1 || !reach(static_cast<std::size_t>(nth)))
+            throw std::out_of_range("REACHED END OF FILE: " + zen::quote(filepath_.string()));
 
-        if (nth != 0)
+        return read_span(nth - 1, nth - 1);
+    }
+
+    // Lines `first` to `last` (inclusive, counting from 1) with a single read
+    std::vector<std::string> lines(int first, int last)
+    {
+        std::vector<std::string> out;
+        if (first < 1 || last < first || !reach(static_cast<std::size_t>(last)))
             throw std::out_of_range("REACHED END OF FILE: " + zen::quote(filepath_.string()));
 
-        return *it;
+        const std::string span = read_span(first - 1, last - 1);
+        out.reserve(static_cast<std::size_t>(last - first + 1));
+        for (int i = first - 1; i < last; ++i) {
+            const auto b = static_cast<std::size_t>(index_[i] - index_[first - 1]);
+            out.emplace_back(span, b, static_cast<std::size_t>(line_end(i) - index_[i]));
+        }
+        return out;
+    }
+
+    // Forgets the line index, e.g. after a write; the next lookup rescans
+    void reindex() {
+        index_    = line_index{};
+        scan_end_ = 0;
+        scanned_  = false;
     }
 
 private:
-    // TODO: Dynamically cache lines that are read the first time?
-    const std::filesystem::path& filepath_;
+    // Where each line starts, known as far as lookups have needed so far.
+    // Kept as varint deltas (one byte per line under 128 chars) with an
+    // absolute offset every 64 lines, so a lookup decodes at most 63 deltas.
+    class line_index {
+    public:
+        std::size_t size() const { return count_; }
+
+        std::uint64_t operator[](std::size_t i) const {
+            const auto& [offset, at] = anchors_[i / STRIDE];
+            std::uint64_t pos = offset;
+            std::size_t   b   = at;
+            for (std::size_t n = i % STRIDE; n > 0; --n)
+                pos += decode(b);
+            return pos;
+        }
+
+        void push(std::uint64_t start) {
+            if (count_ % STRIDE == 0)
+                anchors_.emplace_back(start, deltas_.size());
+            else
+                for (std::uint64_t d = start - last_; ; d >>= 7) {
+                    deltas_.push_back(static_cast<std::uint8_t>(d < 0x80 ? d : (d & 0x7f) | 0x80));
+                    if (d < 0x80)
+                        break;
+                }
+            last_ = start;
+            ++count_;
+        }
+
+    private:
+        static constexpr std::size_t STRIDE = 64;
+
+        std::uint64_t decode(std::size_t& b) const {
+            std::uint64_t d = 0;
+            for (int shift = 0; ; shift += 7) {
+                const std::uint8_t byte = deltas_[b++];
+                d |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+                if (!(byte & 0x80))
+                    return d;
+            }
+        }
+
+        std::vector<std::pair<std::uint64_t, std::size_t>> anchors_;  // offset, first delta after it
+        std::vector<std::uint8_t>                           deltas_;
+        std::uint64_t                                       last_  = 0;
+        std::size_t                                         count_ = 0;
+    };
+
+    // Indexes until line `n` (from 1) and the start of the one after it are
+    // known, or the file ends; false if it has fewer lines
+    bool reach(std::size_t n) {
+        if (index_.size() > n || (scanned_ && index_.size() >= n))
+            return true;
+        if (!raw_.is_open()) {
+            raw_.open(filepath_, std::ios::binary);
+            if (!raw_.is_open())
+                throw std::runtime_error("ERROR OPENING FILE: " + zen::quote(filepath_.string()));
+        }
+        my::flush();                             // our own writes must be visible to raw_
+        if (index_.size() == 0)
+            index_.push(0);
+
+        char buf[1 << 16];
+        raw_.clear();
+        raw_.seekg(static_cast<std::streamoff>(scan_end_));
+        scanned_ = false;
+        while (index_.size() <= n) {
+            raw_.read(buf, sizeof buf);
+            const auto got = static_cast<std::size_t>(raw_.gcount());
+            if (got == 0) {
+                scanned_ = true;
+                break;
+            }
+            for (const char* p = buf; (p = static_cast<const char*>(std::memchr(p, '\n', static_cast<std::size_t>(buf + got - p)))); ++p)
+                index_.push(scan_end_ + static_cast<std::uint64_t>(p - buf) + 1);
+            scan_end_ += got;
+        }
+        return index_.size() >= n;
+    }
+
+    // One past the last character of line `i` (from 0), its '\n' excluded
+    std::uint64_t line_end(std::size_t i) const {
+        return i + 1 < index_.size() ? index_[i + 1] - 1 : scan_end_;
+    }
+
+    // Lines `first` to `last` (from 0) as they are on disk, with one seek and one read
+    std::string read_span(std::size_t first, std::size_t last) {
+        const std::uint64_t b = index_[first];
+        std::string span(static_cast<std::size_t>(line_end(last) - b), '\0');
+        raw_.clear();
+        raw_.seekg(static_cast<std::streamoff>(b));
+        raw_.read(span.data(), static_cast<std::streamsize>(span.size()));
+        return span;
+    }
+
+    std::filesystem::path filepath_;
+    std::ifstream         raw_;              // binary view for the index
+    line_index            index_;
+    std::uint64_t         scan_end_ = 0;     // bytes indexed so far
+    bool                  scanned_  = false; // ... and they were all there was
 
     using my = std::fstream;
 };
 
+// Read-only counterpart of zen::file whose lines are string_views straight
+// into a memory mapping, split with memchr.  Pipes, special files and
+// platforms without mmap are read in 64 KiB chunks instead; there a view
+// only lasts until the next ++ and the file can be walked once.
+// Example: for (std::string_view line : zen::mapped_file("huge.log")) ...
+class mapped_file {
+public:
+    explicit mapped_file(const std::filesystem::path& path)
+    {
+#if ZEN_HAS_MMAP
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw std::runtime_error("ERROR OPENING FILE: " + zen::quote(path.string()));
+        struct stat st {};
+        if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+            const auto len = static_cast<std::size_t>(st.st_size);
+            void* m = ::mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (m != MAP_FAILED) {
+                ::madvise(m, len, MADV_SEQUENTIAL);
+                map_  = m;
+                data_ = static_cast<const char*>(m);
+                size_ = len;
+                eof_  = true;
+            }
+        }
+        ::close(fd);
+        if (map_)
+            return;
+#endif
+        in_.open(path, std::ios::binary);
+        if (!in_.is_open())
+            throw std::runtime_error("ERROR OPENING FILE: " + zen::quote(path.string()));
+    }
+
+    ~mapped_file() {
+#if ZEN_HAS_MMAP
+        if (map_)
+            ::munmap(map_, size_);
+#endif
+    }
+
+    mapped_file(const mapped_file&)            = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+
+    bool is_mapped() const { return map_ != nullptr; }
+
+    // The whole file, if it is mapped; empty otherwise
+    std::string_view view() const { return map_ ? std::string_view(data_, size_) : std::string_view(); }
+
+    // Same lines as zen::file's iterator: a trailing '\n' is followed by
+    // one more, empty, line
+    class iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type        = std::string_view;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = const std::string_view*;
+        using reference         = const std::string_view&;
+
+        iterator(mapped_file& mf, bool end_marker = false)
+            : input_{ mf }, end_marker_{ end_marker }
+        {
+            if (!end_marker_) {
+                input_.rewind();
+                this->operator++();
+            }
+        }
+
+        bool operator!=(const iterator& it) const {
+            return it.end_marker_ != end_marker_;
+        }
+
+        const std::string_view& operator*() const {
+            return line_;
+        }
+
+        iterator& operator++() {
+            end_marker_ = !input_.next(line_);
+            return *this;
+        }
+
+    private:
+        mapped_file&     input_;
+        bool             end_marker_{ false };
+        std::string_view line_;
+    };
+
+    auto begin() { return iterator{ *this }; }
+    auto end()   { return iterator{ *this, true }; }
+
+private:
+    void rewind() {
+        pos_  = 0;
+        done_ = false;
+        if (!map_ && read_) {                             // walked before: start over if it can
+            in_.clear();
+            in_.seekg(0);
+            size_ = 0;
+            eof_  = false;
+            read_ = false;
+            done_ = !in_;                                 // a pipe stays finished
+        }
+    }
+
+    // Cuts the next line off [pos_, size_), reading more if it is chunked
+    bool next(std::string_view& line) {
+        if (done_)
+            return false;
+        for (;;) {
+            const char* p  = data_ + pos_;
+            const char* nl = static_cast<const char*>(std::memchr(p, '\n', size_ - pos_));
+            if (nl) {
+                line  = std::string_view(p, static_cast<std::size_t>(nl - p));
+                pos_ += line.size() + 1;
+                return true;
+            }
+            if (eof_) {
+                line  = std::string_view(p, size_ - pos_);
+                pos_  = size_;
+                done_ = true;
+                return true;
+            }
+            refill();
+        }
+    }
+
+    // Keeps the unfinished line, grows the buffer if it alone fills it, reads on
+    void refill() {
+        const std::size_t keep = size_ - pos_;
+        if (pos_ > 0 && keep > 0)
+            std::memmove(buf_.data(), buf_.data() + pos_, keep);
+        if (buf_.size() < keep + CHUNK)
+            buf_.resize(std::max(buf_.size() * 2, keep + CHUNK));
+        in_.read(buf_.data() + keep, static_cast<std::streamsize>(CHUNK));
+        const auto got = static_cast<std::size_t>(in_.gcount());
+        read_ = true;
+        eof_  = got == 0;
+        data_ = buf_.data();
+        size_ = keep + got;
+        pos_  = 0;
+    }
+
+    static constexpr std::size_t CHUNK = 1 << 16;
+
+    void*                 map_  = nullptr;
+    const char*           data_ = "";
+    std::size_t           size_ = 0;
+    std::size_t           pos_  = 0;
+    bool                  eof_  = false;    // nothing beyond size_
+    bool                  done_ = false;    // last line handed out
+    bool                  read_ = false;    // in_ was read from since the last rewind
+    std::ifstream         in_;              // chunked fallback
+    std::string           buf_;
+};
+
+// Typed, column-selected reader for delimited files like
+// mem_crash_results.csv, built on zen::mapped_file.  The first line that is
+// neither empty nor a '#' comment is the header.  Fields are string_views
+// into the mapping, numbers go through std::from_chars.  Input that cannot
+// be mapped (pipes, special files) is streamed in chunks instead, so memory
+// stays flat: there a row is only valid until the next ++, a pipe can be
+// walked once, and for_each() runs on the calling thread.  There is no
+// quoting: a field cannot hold the delimiter or a newline.
+// Usage:
+// zen::csv_reader csv("mem_crash_results.csv");
+// csv.select({ "Test", "Time_ns" });
+// for (const auto& row : csv)
+//     ns[std::string(row[0])] += row.get<long long>(1);
+// csv.for_each([&](const zen::csv_reader::row& row, unsigned worker) { ... }, 4);
+class csv_reader {
+public:
+    explicit csv_reader(const std::filesystem::path& path, char delimiter = ',')
+        : file_(path), filepath_(path), delimiter_(delimiter)
+    {
+        std::string_view line;
+        if (file_.is_mapped()) {
+            text_ = file_.view();
+            while (next_line(body_, text_.size(), line) && skipped(line)) {}
+        } else {
+            line = header_line_ = start_stream();      // the chunk buffer moves on: keep a copy
+        }
+
+        if (!line.empty() && !skipped(line))
+            for (std::size_t b = 0;;) {
+                const std::size_t d = line.find(delimiter_, b);
+                header_.push_back(line.substr(b, d == std::string_view::npos ? d : d - b));
+                if (d == std::string_view::npos)
+                    break;
+                b = d + 1;
+            }
+        wanted_.resize(header_.size());
+        for (std::size_t c = 0; c < wanted_.size(); ++c)
+            wanted_[c] = static_cast<int>(c);
+    }
+
+    class row {
+    public:
+        std::size_t size() const { return fields_.size(); }
+
+        // Field `i` of the selection; empty if the record is too short
+        std::string_view operator[](std::size_t i) const { return fields_[i]; }
+
+        // The whole record, without its line break
+        std::string_view line() const { return line_; }
+
+        // False unless the whole field parses as a T
+        template<class T>
+        bool get(std::size_t i, T& out) const {
+            const std::string_view f = fields_[i];
+            if constexpr (std::is_same_v<T, std::string_view>) {
+                out = f;
+                return true;
+            } else if constexpr (std::is_same_v<T, std::string>) {
+                out.assign(f);
+                return true;
+            } else {
+                static_assert(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>, "UNSUPPORTED FIELD TYPE");
+                const char* end = f.data() + f.size();
+#if !defined(__cpp_lib_to_chars)
+                if constexpr (std::is_floating_point_v<T>) {      // no floating-point from_chars here
+                    const std::string copy(f);
+                    char* stop = nullptr;
+                    const long double v = std::strtold(copy.c_str(), &stop);
+                    if (copy.empty() || stop != copy.c_str() + copy.size())
+                        return false;
+                    out = static_cast<T>(v);
+                    return true;
+                } else
+#endif
+                {
+                    const auto [ptr, ec] = std::from_chars(f.data(), end, out);
+                    return ec == std::errc() && ptr == end;
+                }
+            }
+        }
+
+        template<class T>
+        T get(std::size_t i) const {
+            T v{};
+            if (!get(i, v))
+                throw std::invalid_argument("FIELD IS NOT A NUMBER: " + zen::quote(std::string(fields_[i])));
+            return v;
+        }
+
+    private:
+        friend class csv_reader;
+
+        void split(std::string_view line, const std::vector<int>& wanted, std::size_t selected, char delimiter) {
+            line_ = line;
+            fields_.assign(selected, std::string_view());
+            for (std::size_t c = 0; c < wanted.size(); ++c) {
+                const void*       d   = std::memchr(line.data(), delimiter, line.size());
+                const std::size_t len = d ? static_cast<std::size_t>(static_cast<const char*>(d) - line.data()) : line.size();
+                if (wanted[c] >= 0)
+                    fields_[static_cast<std::size_t>(wanted[c])] = line.substr(0, len);
+                if (!d)
+                    break;
+                line.remove_prefix(len + 1);
+            }
+        }
+
+        std::vector<std::string_view> fields_;
+        std::string_view              line_;
+    };
+
+    const std::vector<std::string_view>& header() const { return header_; }
+
+    // Position of `name` in the header, -1 if it is not there
+    int column(std::string_view name) const {
+        const auto it = std::find(header_.begin(), header_.end(), name);
+        return it == header_.end() ? -1 : static_cast<int>(it - header_.begin());
+    }
+
+    // Rows get these columns, in this order; the rest is never looked at.
+    // No names selects every column again.
+    csv_reader& select(const std::vector<std::string_view>& names) {
+        std::vector<int> wanted;
+        if (names.empty())
+            for (std::size_t c = 0; c < header_.size(); ++c)
+                wanted.push_back(static_cast<int>(c));
+        for (std::size_t i = 0; i < names.size(); ++i) {
+            const int c = column(names[i]);
+            if (c < 0)
+                throw std::invalid_argument("NO SUCH COLUMN: " + zen::quote(std::string(names[i])) + " IN " + zen::quote(filepath_.string()));
+            if (wanted.size() <= static_cast<std::size_t>(c))
+                wanted.resize(static_cast<std::size_t>(c) + 1, -1);
+            wanted[static_cast<std::size_t>(c)] = static_cast<int>(i);
+        }
+        wanted_   = std::move(wanted);
+        selected_ = names.size();
+        return *this;
+    }
+
+    class iterator {
+    public:
+        iterator(const csv_reader& csv, bool end_marker = false)
+            : csv_{ csv }, pos_{ csv.body_ }, end_marker_{ end_marker }
+        {
+            if (!end_marker_) {
+                if (csv_.streamed() && !std::exchange(csv_.fresh_, false))
+                    csv_.start_stream();                  // the constructor's walk was used up
+                this->operator++();
+            }
+        }
+
+        bool operator!=(const iterator& it) const {
+            return it.end_marker_ != end_marker_;
+        }
+
+        const row& operator*() const {
+            return row_;
+        }
+
+        iterator& operator++() {
+            if (csv_.streamed())
+                end_marker_ = !csv_.next_streamed(row_, started_);
+            else
+                end_marker_ = !csv_.next_record(pos_, csv_.text_.size(), row_);
+            started_ = true;
+            return *this;
+        }
+
+    private:
+        const csv_reader& csv_;
+        std::size_t       pos_;
+        bool              end_marker_{ false };
+        bool              started_{ false };    // streamed: a row was handed out, move past it first
+        row               row_;
+    };
+
+    auto begin() const { return iterator{ *this }; }
+    auto end()   const { return iterator{ *this, true }; }
+
+    // Calls f(row, worker) for every record.  With several threads the
+    // records are cut into one contiguous run per worker, split at line
+    // breaks, so f must be safe to call concurrently; each worker sees its
+    // run in file order.
+    template<class F>
+    void for_each(F f, unsigned threads = 1) const {
+        if (streamed()) {
+            for (const auto& r : *this)
+                f(r, 0u);
+            return;
+        }
+        if (threads == 0)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        const std::size_t len = text_.size() - body_;
+        threads = static_cast<unsigned>(std::min<std::size_t>(threads, std::max<std::size_t>(len / 4096, 1)));
+
+        std::vector<std::size_t> cut(threads + 1, text_.size());
+        cut[0] = body_;
+        for (unsigned t = 1; t < threads; ++t) {
+            const std::size_t nl = text_.find('\n', std::max(body_ + len / threads * t, cut[t - 1]));
+            cut[t] = nl == std::string_view::npos ? text_.size() : nl + 1;
+        }
+
+        auto run = [&](unsigned t) {
+            row r;
+            for (std::size_t pos = cut[t]; next_record(pos, cut[t + 1], r);)
+                f(static_cast<const row&>(r), t);
+        };
+        std::vector<std::thread> pool;
+        for (unsigned t = 1; t < threads; ++t)
+            pool.emplace_back(run, t);
+        run(0);
+        for (auto& t : pool)
+            t.join();
+    }
+
+private:
+    static bool skipped(std::string_view line) { return line.empty() || line[0] == '#'; }
+
+    bool streamed() const { return !file_.is_mapped(); }
+
+    // Streamed input: (re)starts the walk and moves past the header, which
+    // is returned; a pipe read before yields nothing
+    std::string start_stream() const {
+        lines_.emplace(file_.begin());
+        std::string header;
+        for (; *lines_ != file_.end(); ++*lines_)
+            if (!skipped(strip_cr(**lines_))) {
+                header = strip_cr(**lines_);
+                ++*lines_;
+                break;
+            }
+        return header;
+    }
+
+    // Streamed input: the next record, moving past the current one first
+    // unless it has not been handed out yet
+    bool next_streamed(row& r, bool advance) const {
+        if (advance && *lines_ != file_.end())
+            ++*lines_;
+        for (; *lines_ != file_.end(); ++*lines_) {
+            const std::string_view line = strip_cr(**lines_);
+            if (!skipped(line)) {
+                r.split(line, wanted_, selected_ ? selected_ : wanted_.size(), delimiter_);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static std::string_view strip_cr(std::string_view line) {
+        if (!line.empty() && line.back() == '\r')
+            line.remove_suffix(1);
+        return line;
+    }
+
+    // The line at `pos` (before `end`) without its "\r\n", pos moved past it
+    bool next_line(std::size_t& pos, std::size_t end, std::string_view& line) const {
+        if (pos >= end)
+            return false;
+        const char*       p  = text_.data() + pos;
+        const void*       nl = std::memchr(p, '\n', end - pos);
+        const std::size_t n  = nl ? static_cast<std::size_t>(static_cast<const char*>(nl) - p) : end - pos;
+        line = std::string_view(p, n);
+        if (!line.empty() && line.back() == '\r')
+            line.remove_suffix(1);
+        pos += n + 1;
+        return true;
+    }
+
+    bool next_record(std::size_t& pos, std::size_t end, row& r) const {
+        std::string_view line;
+        while (next_line(pos, end, line))
+            if (!skipped(line)) {
+                r.split(line, wanted_, selected_ ? selected_ : wanted_.size(), delimiter_);
+                return true;
+            }
+        return false;
+    }
+
+    mutable mapped_file           file_;       // walking a stream moves it on
+    std::filesystem::path         filepath_;
+    char                          delimiter_;
+    std::string                   header_line_;    // streamed: what header_ points into
+    mutable std::optional<mapped_file::iterator> lines_;  // streamed: the current line
+    mutable bool                  fresh_ = true;   // streamed: lines_ is right after the header, unused
+    std::string_view              text_;
+    std::size_t                   body_     = 0;   // first byte after the header
+    std::vector<std::string_view> header_;
+    std::vector<int>              wanted_;         // column → slot in a row, -1 = not selected
+    std::size_t                   selected_ = 0;   // 0 = every column
+};
+
 namespace literals::path {
 
 std::filesystem::path operator ""_path(const char* str, std::size_t length)
@@ -1913,51 +2885,285 @@ zen::string repeat(const int n, const std::string_view s) {
 
 ///////////////////////////////////////////////////////////////////////////////////////////// MAIN UTILITIES
 
+// ------------------------------------------------------------------------------------------ random
+
+// xoshiro256++ (Blackman & Vigna): 256 bits of state, 64-bit output, fast
+// and statistically solid.  A UniformRandomBitGenerator, so it also works
+// with the <random> distributions.
+class xoshiro256pp {
+public:
+    using result_type = std::uint64_t;
+
+    explicit xoshiro256pp(std::uint64_t seed = 0x9e3779b97f4a7c15ULL) {
+        for (auto& x : s_)
+            x = splitmix64(seed);               // never all zero
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return ~result_type(0); }
+
+    result_type operator()() {
+        const std::uint64_t result = rotl(s_[0] + s_[3], 23) + s_[0];
+        const std::uint64_t t      = s_[1] << 17;
+        s_[2] ^= s_[0];
+        s_[3] ^= s_[1];
+        s_[1] ^= s_[2];
+        s_[0] ^= s_[3];
+        s_[2] ^= t;
+        s_[3]  = rotl(s_[3], 45);
+        return result;
+    }
+
+    // Skips 2^128 outputs: streams one jump apart never overlap in practice
+    void jump() {
+        constexpr std::uint64_t JUMP[] = { 0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+                                           0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL };
+        std::uint64_t t[4] = {};
+        for (std::uint64_t j : JUMP)
+            for (int b = 0; b < 64; ++b) {
+                if (j & (std::uint64_t(1) << b))
+                    for (int i = 0; i < 4; ++i)
+                        t[i] ^= s_[i];
+                (*this)();
+            }
+        std::copy(std::begin(t), std::end(t), std::begin(s_));
+    }
+
+    const std::uint64_t* state() const { return s_; }
+
+    static std::uint64_t splitmix64(std::uint64_t& x) {
+        std::uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+private:
+    static std::uint64_t rotl(std::uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+    std::uint64_t s_[4];
+};
+
+namespace internal {
+    // Integers as 64 bits, sign-extended if signed, so max - min + 1 is the range
+    template<class T>
+    std::uint64_t widen(T x) {
+        return static_cast<std::uint64_t>(static_cast<std::conditional_t<std::is_signed_v<T>, long long, unsigned long long>>(x));
+    }
+
+    template<class C, class = void> struct has_data : std::false_type {};
+    template<class C>
+    struct has_data<C, std::void_t<decltype(std::data(std::declval<C&>()))>>
+        : std::is_pointer<decltype(std::data(std::declval<C&>()))> {};
+
+    // High 64 bits of a * b; the low ones go to `lo`
+    inline std::uint64_t mul_hi(std::uint64_t a, std::uint64_t b, std::uint64_t& lo) {
+#if defined(__SIZEOF_INT128__)
+        __extension__ typedef unsigned __int128 u128;   // no -Wpedantic warning
+        const u128 p = static_cast<u128>(a) * b;
+        lo = static_cast<std::uint64_t>(p);
+        return static_cast<std::uint64_t>(p >> 64);
+#else
+        const std::uint64_t a_lo = a & 0xffffffffu, a_hi = a >> 32;
+        const std::uint64_t b_lo = b & 0xffffffffu, b_hi = b >> 32;
+        const std::uint64_t ll = a_lo * b_lo, lh = a_lo * b_hi, hl = a_hi * b_lo, hh = a_hi * b_hi;
+        const std::uint64_t mid = (ll >> 32) + (lh & 0xffffffffu) + (hl & 0xffffffffu);
+        lo = (mid << 32) | (ll & 0xffffffffu);
+        return hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+#endif
+    }
+} // namespace internal
+
+// wyrand (Wang Yi): 64 bits of state and one multiply per output, the
+// fastest of the lot for test data that needs no more than that
+class wyrand {
+public:
+    using result_type = std::uint64_t;
+
+    explicit wyrand(std::uint64_t seed = 0) : state_(seed) {}
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return ~result_type(0); }
+
+    result_type operator()() {
+        state_ += 0xa0761d6478bd642fULL;
+        std::uint64_t lo;
+        const std::uint64_t hi = internal::mul_hi(state_, state_ ^ 0xe7037ed1a0b428dbULL, lo);
+        return hi ^ lo;
+    }
+
+private:
+    std::uint64_t state_;
+};
+
+// This thread's generator, seeded once from std::random_device and a
+// per-thread counter, so threads never share state or a sequence
+inline xoshiro256pp& thread_rng() {
+    static std::atomic<std::uint64_t> threads{ 0 };
+    thread_local xoshiro256pp rng([] {
+        std::random_device rd;
+        std::uint64_t seed = (std::uint64_t(rd()) << 32) ^ rd();
+        std::uint64_t id   = threads.fetch_add(1, std::memory_order_relaxed);
+        return seed ^ xoshiro256pp::splitmix64(id);
+    }());
+    return rng;
+}
+
+// Unbiased integer in [0, range) with Lemire's multiply-and-reject: one
+// multiply, and a division only in the rare case the draw is near a boundary.
+// range == 0 means the whole 64 bits.
+template<class G>
+std::uint64_t random_below(G& g, std::uint64_t range) {
+    if (range == 0)
+        return g();
+    std::uint64_t lo;
+    std::uint64_t hi = internal::mul_hi(g(), range, lo);
+    if (lo < range) {
+        const std::uint64_t threshold = (0 - range) % range;
+        while (lo < threshold)
+            hi = internal::mul_hi(g(), range, lo);
+    }
+    return hi;
+}
+
 // Example: random_int();
-// Result: A random integer between [min, max)
+// Result: A random integer between [min, max], both included
+// Thread-safe: every thread draws from its own thread_rng().
 template<class T = int>
 T random_int(const T min = 0, const T max = 10) {
-    // Reasons why the std::random_device and the std::mt19937 are 'static' below:
-    // ---------------------------------------------------------------------------------------------------------------
-    // 1. Initialization Efficiency:
-    // Random devices and generators often involve some computational cost due to entropy gathering, seeding, generator
-    // initialization and good old algorithmic complexity. By declaring them as static, they are initialized only once,
-    // the first time the function is called. Subsequent calls to to this function reuse the existing instances, avoiding the overhead.
-    // ---------------------------------------------------------------------------------------------------------------
-    // 2. State Preservation:
-    // Random number generators like std::mt19937 maintain an internal state that evolves as numbers are generated.
-    // This state determines the sequence of random numbers produced. By making the std::mt19937 object static,
-    // the state is preserved across calls to this function, ensuring a proper random sequence. If the std::mt19937
-    // object were reinitialized on every call, it might lead to repeated or patterned sequences, undermining the randomness.
-    // ---------------------------------------------------------------------------------------------------------------
-    // 3. Thread Safety Considerations:
-    // Declaring these variables as static within a function means they are shared across all calls to that function
-    // within the program, regardless of where it's called from. This could potentially raise thread-safety issues if the
-    // function is called simultaneously from multiple threads. However, in most common usage scenarios where thread
-    // safety is not a concern, using static variables for this purpose is fine.
-    // ---------------------------------------------------------------------------------------------------------------
-    // 4. Resource Management
-    // Since the std::random_device and the std::mt19937 object are static, they are not destroyed when the function returns,
-    // but rather when the program ends. This ensures that the same random device and generator instances are reused
-    // throughout the lifetime of the program, optimizing resource management.
-    // ---------------------------------------------------------------------------------------------------------------
-    // 5. Avoiding Repetition
-    // If we didn't make these objects static, and the random number generator was reseeded with the same or similar
-    // seeds (which might happen if the function is called in quick succession), you might get the same or similar random
-    // numbers in different calls. Making these static ensures a more varied and truly random sequence.
-    // ---------------------------------------------------------------------------------------------------------------
-    // The 'static' below is for reasons outlined above.
-    static std::random_device        rd;
-    static std::mt19937              gen(rd());
-    std::uniform_int_distribution<T> dis(min, max);
-    return dis(gen);
+    ZEN_STATIC_ASSERT((std::is_integral_v<T> && !std::is_same_v<T, bool>), "TEMPLATE PARAMETER EXPECTED TO BE AN INTEGER TYPE");
+    const std::uint64_t lo    = internal::widen(min);
+    const std::uint64_t range = internal::widen(max) - lo + 1;
+    return static_cast<T>(lo + random_below(thread_rng(), range));
+}
+
+namespace internal {
+    // Eight xoshiro256++ streams side by side, one jump() apart, kept as a
+    // structure of arrays: a block of outputs is plain element-wise
+    // arithmetic that the compiler turns into SIMD
+    struct xoshiro_lanes {
+        static constexpr std::size_t N = 8;
+
+        explicit xoshiro_lanes(xoshiro256pp g) {
+            for (std::size_t i = 0; i < N; ++i, g.jump()) {
+                s0[i] = g.state()[0];
+                s1[i] = g.state()[1];
+                s2[i] = g.state()[2];
+                s3[i] = g.state()[3];
+            }
+        }
+
+        void next(std::uint64_t* out) {
+            for (std::size_t i = 0; i < N; ++i) {
+                const std::uint64_t sum = s0[i] + s3[i];
+                out[i] = ((sum << 23) | (sum >> 41)) + s0[i];
+                const std::uint64_t t = s1[i] << 17;
+                s2[i] ^= s0[i];
+                s3[i] ^= s1[i];
+                s1[i] ^= s2[i];
+                s0[i] ^= s3[i];
+                s2[i] ^= t;
+                s3[i]  = (s3[i] << 45) | (s3[i] >> 19);
+            }
+        }
+
+        alignas(64) std::uint64_t s0[N], s1[N], s2[N], s3[N];
+    };
+
+    // Lane i starts i jumps past thread_rng(), which is then moved past all
+    // of them: random_int() calls (rejection redraws, tails) never replay a lane
+    inline xoshiro_lanes& thread_lanes() {
+        thread_local xoshiro_lanes lanes([] {
+            xoshiro256pp g = thread_rng();
+            for (std::size_t i = 0; i < xoshiro_lanes::N; ++i)
+                thread_rng().jump();
+            return g;
+        }());
+        return lanes;
+    }
+} // namespace internal
+
+// Fills out[0, n) in bulk: integers uniform in [min, max] (unbiased, as
+// random_int), floating point in [min, max).  Eight generator streams run
+// in lockstep so the loops vectorize; each thread has its own.
+template<class T>
+void generate_random(T* out, std::size_t n, const T min, const T max) {
+    ZEN_STATIC_ASSERT((std::is_arithmetic_v<T> && !std::is_same_v<T, bool>), "TEMPLATE PARAMETER EXPECTED TO BE ARITHMETIC");
+    constexpr std::size_t N = internal::xoshiro_lanes::N;
+    auto& lanes = internal::thread_lanes();
+    alignas(64) std::uint64_t block[N];
+    std::size_t i = 0;
+
+    if constexpr (std::is_floating_point_v<T>) {
+        // As many top bits as T has digits, so the unit value is exact and
+        // below 1; min + span * u can still round up to max, hence the clamp
+        constexpr int BITS = std::min(std::numeric_limits<T>::digits, 64);
+        const T unit = std::ldexp(T(1), -BITS);
+        const T span = max - min;
+        const T top  = max > min ? std::nextafter(max, min) : min;
+        auto real = [&](std::uint64_t bits) {
+            const T x = min + span * (static_cast<T>(bits >> (64 - BITS)) * unit);
+            return x < max ? x : top;
+        };
+        for (; i + N <= n; i += N) {
+            lanes.next(block);
+            for (std::size_t j = 0; j < N; ++j)
+                out[i + j] = real(block[j]);
+        }
+        if (i < n) {
+            lanes.next(block);
+            for (std::size_t j = 0; i < n; ++i, ++j)
+                out[i] = real(block[j]);
+        }
+    } else {
+        const std::uint64_t lo    = internal::widen(min);
+        const std::uint64_t range = internal::widen(max) - lo + 1;
+        if (range != 0 && range < (std::uint64_t(1) << 32)) {
+            // Two 32-bit draws per output, Lemire in 32 bits; the rare draw
+            // that must be rejected is redone afterwards
+            const auto r32       = static_cast<std::uint32_t>(range);
+            const auto threshold = static_cast<std::uint32_t>(0u - r32) % r32;
+            for (; i + 2 * N <= n; i += 2 * N) {
+                lanes.next(block);
+                std::uint32_t reject = 0;
+                for (std::size_t j = 0; j < N; ++j) {
+                    const std::uint64_t a = (block[j] & 0xffffffffu) * r32;
+                    const std::uint64_t b = (block[j] >> 32) * r32;
+                    out[i + 2 * j]     = static_cast<T>(lo + (a >> 32));
+                    out[i + 2 * j + 1] = static_cast<T>(lo + (b >> 32));
+                    reject |= static_cast<std::uint32_t>(static_cast<std::uint32_t>(a) < threshold)
+                            | static_cast<std::uint32_t>(static_cast<std::uint32_t>(b) < threshold);
+                }
+                if (reject)
+                    for (std::size_t j = 0; j < N; ++j) {
+                        if (static_cast<std::uint32_t>((block[j] & 0xffffffffu) * r32) < threshold)
+                            out[i + 2 * j]     = random_int(min, max);
+                        if (static_cast<std::uint32_t>((block[j] >> 32) * r32) < threshold)
+                            out[i + 2 * j + 1] = random_int(min, max);
+                    }
+            }
+        } else {
+            for (; i + N <= n; i += N) {
+                lanes.next(block);
+                for (std::size_t j = 0; j < N; ++j) {
+                    std::uint64_t low;
+                    const std::uint64_t hi = internal::mul_hi(block[j], range, low);
+                    out[i + j] = range == 0          ? static_cast<T>(block[j])
+                               : low < range && low < (0 - range) % range ? random_int(min, max)
+                                                     : static_cast<T>(lo + hi);
+                }
+            }
+        }
+        for (; i < n; ++i)
+            out[i] = random_int(min, max);
+    }
 }
 
 // Very often all we want is a dead simple way of quickly
 // generating a container filled with some random numbers.
 // Example: std::vector<int> v;
 //          zen::generate_random(v);
-// Result: A vector of size 10 with random integers between [min, max)
+// Result: A vector of size 10 with random integers between [10, 99]
 template<class Iterable>
 void generate_random(Iterable& c, int size = 10) // TODO: Maybe generalize this to make it work with all containers
 {
@@ -1967,7 +3173,12 @@ void generate_random(Iterable& c, int size = 10) // TODO: Maybe generalize this
     if (std::empty(c))
         c.resize(size);
 
-    std::generate(std::begin(c), std::end(c), [&]() { return random_int(10, 99); });
+    using T = std::decay_t<decltype(*std::begin(c))>;
+    if constexpr (std::is_integral_v<T> && !std::is_same_v<T, bool>
+               && internal::has_data<Iterable>::value)               // contiguous: fill in bulk
+        generate_random(std::data(c), std::size(c), T(10), T(99));
+    else
+        std::generate(std::begin(c), std::end(c), [&]() { return random_int(10, 99); });
 }
 
 // Over the years it has become clear that the standard member
@@ -2040,6 +3251,298 @@ auto count_if(const Iterable& c, Pred p)
     return count;
 }
 
+// ------------------------------------------------------------------------------------------ execution policies
+
+// Policies for sum(), count() and count_if(), named after std::execution's
+// but needing no parallel STL backend:
+//   seq       - the plain loops above, same order and result
+//   par       - large ranges split across a thread pool, each chunk in order
+//   par_unseq - par, and each chunk reduced with several independent
+//               accumulators so that it vectorizes (float results may differ
+//               in the last bits from seq)
+// threads = 0 uses every hardware thread.
+// Example: zen::sum(zen::execution::par_unseq, reals);
+//          zen::sum(zen::execution::par, reals, zen::summation::kahan);
+namespace execution {
+    struct sequenced_policy             {};
+    struct parallel_policy              { unsigned threads = 0; };
+    struct parallel_unsequenced_policy  { unsigned threads = 0; };
+
+    inline constexpr sequenced_policy            seq{};
+    inline constexpr parallel_policy             par{};
+    inline constexpr parallel_unsequenced_policy par_unseq{};
+
+    template<class T> struct is_execution_policy : std::false_type {};
+    template<> struct is_execution_policy<sequenced_policy>            : std::true_type {};
+    template<> struct is_execution_policy<parallel_policy>             : std::true_type {};
+    template<> struct is_execution_policy<parallel_unsequenced_policy> : std::true_type {};
+    template<class T> constexpr bool is_execution_policy_v = is_execution_policy<std::decay_t<T>>::value;
+} // namespace execution
+
+// How sum() adds floating-point values up
+enum class summation {
+    naive,      // running total(s): fastest, error grows with n
+    kahan,      // compensated: error independent of n (lost again under -ffast-math)
+    pairwise,   // recursive halving: error grows with log n, nearly as fast as naive
+};
+
+namespace internal {
+    // Worker threads for the parallel reductions, started on first use.  A
+    // call from inside a worker runs inline, so nesting cannot deadlock.
+    class task_pool {
+    public:
+        static task_pool& instance() {
+            static task_pool pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+            return pool;
+        }
+
+        unsigned threads() const { return static_cast<unsigned>(workers_.size()) + 1; }
+
+        // Runs f(0) … f(n - 1) on up to `threads` threads, the caller's included
+        template<class F>
+        void run(std::size_t n, unsigned threads, const F& f) {
+            const std::size_t helpers = in_worker() ? 0 : std::min<std::size_t>({ n, threads, this->threads() }) - 1;
+            std::atomic<std::size_t> next{ 0 };
+            std::atomic<std::size_t> finished{ 0 };
+            auto work = [&] {
+                for (std::size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < n;)
+                    f(i);
+            };
+            if (helpers > 0) {
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    for (std::size_t h = 0; h < helpers; ++h)
+                        queue_.emplace_back([&] { work(); finished.fetch_add(1, std::memory_order_release); });
+                }
+                wake_.notify_all();
+            }
+            work();
+            while (finished.load(std::memory_order_acquire) < helpers)   // helpers still use our stack
+                std::this_thread::yield();
+        }
+
+        ~task_pool() {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stop_ = true;
+            }
+            wake_.notify_all();
+            for (auto& w : workers_)
+                w.join();
+        }
+
+    private:
+        explicit task_pool(unsigned workers) {
+            for (unsigned i = 0; i < workers; ++i)
+                workers_.emplace_back([this] {
+                    in_worker() = true;
+                    for (;;) {
+                        std::function<void()> job;
+                        {
+                            std::unique_lock<std::mutex> lock(mutex_);
+                            wake_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+                            if (queue_.empty())
+                                return;
+                            job = std::move(queue_.front());
+                            queue_.pop_front();
+                        }
+                        job();
+                    }
+                });
+        }
+
+        static bool& in_worker() {
+            thread_local bool flag = false;
+            return flag;
+        }
+
+        std::vector<std::thread>          workers_;
+        std::deque<std::function<void()>> queue_;
+        std::mutex                        mutex_;
+        std::condition_variable           wake_;
+        bool                              stop_ = false;
+    };
+
+    // Below this many elements per chunk the threads cost more than they save
+    constexpr std::size_t MIN_CHUNK = std::size_t(1) << 15;
+
+    // reduce(begin, length) over [first, first + n), chunked across the pool
+    // when the policy is parallel; chunk results are combined in order
+    template<class R, class Policy, class It, class Reduce, class Combine>
+    R reduce_chunks(const Policy& policy, It first, std::size_t n, Reduce reduce, Combine combine) {
+        unsigned threads = 1;
+        if constexpr (!std::is_same_v<std::decay_t<Policy>, execution::sequenced_policy>)
+            threads = policy.threads ? policy.threads : task_pool::instance().threads();
+        const std::size_t chunks = std::min<std::size_t>(threads * std::size_t(4), n / MIN_CHUNK);
+        if (threads <= 1 || chunks <= 1)
+            return reduce(first, n);
+
+        std::vector<R> partial(chunks);
+        task_pool::instance().run(chunks, threads, [&](std::size_t c) {
+            const std::size_t b = n * c / chunks, e = n * (c + 1) / chunks;
+            partial[c] = reduce(first + static_cast<std::ptrdiff_t>(b), e - b);
+        });
+        return combine(partial);
+    }
+
+    constexpr std::size_t LANES = 8;     // independent accumulators: a vector's worth for most types
+
+    template<class T, bool Lanes>
+    T sum_naive(const T* p, std::size_t n) {
+        std::size_t i = 0;
+        T total{};
+        if constexpr (Lanes) {
+            T acc[LANES] = {};
+            for (; i + LANES <= n; i += LANES)
+                for (std::size_t j = 0; j < LANES; ++j)
+                    acc[j] += p[i + j];
+            for (std::size_t j = 0; j < LANES; ++j)
+                total += acc[j];
+        }
+        for (; i < n; ++i)
+            total += p[i];
+        return total;
+    }
+
+    // Kahan running sum; `c` is the low-order part lost so far, negated,
+    // and goes back in with the next term (a naively summed correction,
+    // as in Neumaier's variant, drifts with n in float)
+    template<class T>
+    struct compensated {
+        T s{}, c{};
+
+        void add(T x) {
+            const T y = x - c;
+            const T t = s + y;
+            c = (t - s) - y;
+            s = t;
+        }
+        T value() const { return s - c; }
+    };
+
+    template<class T, bool Lanes>
+    compensated<T> sum_kahan(const T* p, std::size_t n) {
+        std::size_t    i = 0;
+        compensated<T> total;
+        if constexpr (Lanes) {                   // classic Kahan per lane: branch-free, vectorizes
+            T s[LANES] = {}, c[LANES] = {};
+            for (; i + LANES <= n; i += LANES)
+                for (std::size_t j = 0; j < LANES; ++j) {
+                    const T y = p[i + j] - c[j];
+                    const T t = s[j] + y;
+                    c[j] = (t - s[j]) - y;
+                    s[j] = t;
+                }
+            for (std::size_t j = 0; j < LANES; ++j) {
+                total.add(s[j]);
+                total.add(-c[j]);
+            }
+        }
+        for (; i < n; ++i)
+            total.add(p[i]);
+        return total;
+    }
+
+    template<class T, bool Lanes>
+    T sum_pairwise(const T* p, std::size_t n) {
+        if (n <= 256)
+            return sum_naive<T, Lanes>(p, n);
+        const std::size_t half = n / 2;
+        return sum_pairwise<T, Lanes>(p, half) + sum_pairwise<T, Lanes>(p + half, n - half);
+    }
+
+    // x keeps its own type: the comparison converts exactly as count(c, x) does
+    template<class T, bool Lanes, class X>
+    std::size_t count_equal(const T* p, std::size_t n, const X x) {
+        std::size_t total = 0;
+        for (std::size_t i = 0; i < n; ++i)     // a compare and an add: vectorizes as is
+            total += p[i] == x;
+        return total;
+    }
+} // namespace internal
+
+// sum() with an execution policy.  Contiguous ranges of arithmetic values
+// take the fast paths; anything else is summed as by sum(c).
+template<class Policy, class Iterable,
+         class = std::enable_if_t<execution::is_execution_policy_v<Policy>>>
+auto sum(const Policy& policy, const Iterable& c, const summation how = summation::naive)
+{
+    using T = std::decay_t<decltype(*std::begin(c))>;
+    if constexpr (std::is_arithmetic_v<T> && internal::has_data<const Iterable>::value) {
+        constexpr bool lanes = std::is_same_v<std::decay_t<Policy>, execution::parallel_unsequenced_policy>;
+        const T*          p  = std::data(c);
+        const std::size_t n  = std::size(c);
+        auto add_all = [](const std::vector<T>& partial) { return internal::sum_naive<T, false>(partial.data(), partial.size()); };
+
+        if constexpr (std::is_floating_point_v<T>) {     // integers never see the compensated paths
+            if (how == summation::kahan) {
+                using K = internal::compensated<T>;
+                const K total = internal::reduce_chunks<K>(policy, p, n,
+                    [](const T* b, std::size_t len) { return internal::sum_kahan<T, lanes>(b, len); },
+                    [](const std::vector<K>& partial) {
+                        K k;
+                        for (const auto& x : partial) {
+                            k.add(x.s);
+                            k.add(-x.c);
+                        }
+                        return k;
+                    });
+                return total.value();
+            }
+            if (how == summation::pairwise)
+                return internal::reduce_chunks<T>(policy, p, n,
+                    [](const T* b, std::size_t len) { return internal::sum_pairwise<T, lanes>(b, len); }, add_all);
+        }
+        return internal::reduce_chunks<T>(policy, p, n,
+            [](const T* b, std::size_t len) { return internal::sum_naive<T, lanes>(b, len); }, add_all);
+    } else {
+        return static_cast<T>(sum(c));
+    }
+}
+
+// count() with an execution policy; random-access ranges are split across threads
+template<class Policy, class Iterable, class EqualityComparable,
+         class = std::enable_if_t<execution::is_execution_policy_v<Policy>>>
+auto count(const Policy& policy, const Iterable& c, const EqualityComparable& x)
+{
+    using T  = std::decay_t<decltype(*std::begin(c))>;
+    using It = decltype(std::begin(c));
+    auto add_all = [](const std::vector<size_t>& partial) { return std::accumulate(partial.begin(), partial.end(), size_t(0)); };
+
+    if constexpr (std::is_arithmetic_v<T> && std::is_arithmetic_v<EqualityComparable>
+               && internal::has_data<const Iterable>::value) {
+        constexpr bool lanes = std::is_same_v<std::decay_t<Policy>, execution::parallel_unsequenced_policy>;
+        return internal::reduce_chunks<size_t>(policy, std::data(c), std::size(c),
+            [&x](const T* b, std::size_t len) { return internal::count_equal<T, lanes>(b, len, x); }, add_all);
+    } else if constexpr (std::is_base_of_v<std::random_access_iterator_tag, typename std::iterator_traits<It>::iterator_category>) {
+        return internal::reduce_chunks<size_t>(policy, std::begin(c), static_cast<std::size_t>(std::size(c)),
+            [&x](It b, std::size_t len) { return static_cast<size_t>(std::count(b, b + static_cast<std::ptrdiff_t>(len), x)); }, add_all);
+    } else {
+        return count(c, x);
+    }
+}
+
+// count_if() with an execution policy; under par / par_unseq `p` is called
+// from several threads at once
+template<class Policy, class Iterable, class Pred,
+         class = std::enable_if_t<execution::is_execution_policy_v<Policy>>>
+auto count_if(const Policy& policy, const Iterable& c, Pred p)
+{
+    using It = decltype(std::begin(c));
+    if constexpr (std::is_base_of_v<std::random_access_iterator_tag, typename std::iterator_traits<It>::iterator_category>) {
+        return internal::reduce_chunks<size_t>(policy, std::begin(c), static_cast<std::size_t>(std::size(c)),
+            [&p](It b, std::size_t len) {
+                size_t n = 0;
+                for (std::size_t i = 0; i < len; ++i)
+                    n += p(b[static_cast<std::ptrdiff_t>(i)]) ? 1 : 0;
+                return n;
+            },
+            [](const std::vector<size_t>& partial) { return std::accumulate(partial.begin(), partial.end(), size_t(0)); });
+    } else {
+        return count_if(c, p);
+    }
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////// LPS (Log, Print, String)
 // 
 // Printing and logging in Kaizen follows the LPS principle of textual visualization.
@@ -2048,91 +3551,463 @@ auto count_if(const Iterable& c, Pred p)
 // 2. print()     - uses to_string() to output the object (as a string)
 // 3. log()       - uses print() and adds any formatting, new lines at the end, etc.
 
-// ------------------------------------------------------------------------------------------ stringify
+// ------------------------------------------------------------------------------------------ flush policy
 
-// Converts most of the widely used data types to a string.
-// Example: std::vector<int> v = {1, 3, 3};
-// Example: to_string(vec) Result: [1, 2, 3]
-// Example: to_string(42)  Result: "42"
-template<class T>
-zen::string to_string(const T& x) {
-    std::stringstream ss;
-    
-    // First check for string-likeness so that zen::pring("abc") prints "abc"
-    // and not [a, b, c] as a result of considering strings as iterable below
-    if constexpr (is_string_like<T>()) {
-        return x;
-    } else if constexpr (is_iterable_v<T>) {
-        ss << "[";
-        auto it = std::begin(x);
-        if (it != std::end(x)) {
-            if constexpr (is_string_like<decltype(*it)>())
-                ss << quote(to_string(*it++));
-            else
-                ss << to_string(*it++);              // recursive call to handle nested iterables
+// print() and log() format into a per-thread buffer, and every call leaves
+// it in one std::cout.write() instead of item by item.  The policy decides
+// when the buffer is handed over:
+enum class flush_policy {
+    call,   // at the end of each print()/log() call (default), so it stays in order with std::cout
+    line,   // the same, plus std::cout.flush() after each log(), as std::endl did
+    size,   // once `flush_bytes` have piled up, on zen::flush() and at thread exit; for hot
+            // loops whose output does not interleave with other writes to std::cout
+};
+
+namespace internal {
+    struct lps_settings {
+        std::atomic<flush_policy> policy{ flush_policy::call };
+        std::atomic<std::size_t>  flush_bytes{ std::size_t(1) << 16 };
+    };
+
+    inline lps_settings& lps() {
+        static lps_settings settings;
+        return settings;
+    }
+
+    struct lps_buffer {
+        std::string text;
+
+        ~lps_buffer() { hand_over(); }        // also runs for the main thread on exit()
+
+        void hand_over() {
+            if (!text.empty()) {
+                std::cout.write(text.data(), static_cast<std::streamsize>(text.size()));
+                text.clear();                 // keeps the capacity
+            }
         }
-        for (; it != std::end(x); ++it) {
-            if constexpr (is_string_like<decltype(*it)>())
-                ss << ", " << quote(to_string(*it)); // recursive call to handle nested iterables
-            else
-                ss << ", " << to_string(*it);        // recursive call to handle nested iterables
+
+        void done(bool line) {
+            const flush_policy p = lps().policy.load(std::memory_order_relaxed);
+            if (p != flush_policy::size || text.size() >= lps().flush_bytes.load(std::memory_order_relaxed))
+                hand_over();
+            if (p == flush_policy::line && line)
+                std::cout.flush();
         }
-        ss << "]";
-    } else { // not iterable, single item
-        ss << x;
+    };
+
+    inline lps_buffer& lps_out() {
+        thread_local lps_buffer buffer;
+        return buffer;
     }
-    return ss.str();
+} // namespace internal
+
+inline void set_flush_policy(flush_policy p, std::size_t flush_bytes = std::size_t(1) << 16) {
+    internal::lps().flush_bytes.store(flush_bytes, std::memory_order_relaxed);
+    internal::lps().policy.store(p, std::memory_order_relaxed);
 }
 
-// Recursive variadic template to handle multiple arguments
-template<class T, class... Args>
-inline zen::string to_string(const T& x, const Args&... args) {
-    return to_string(x) + " " + to_string(args...);
+// Hands this thread's buffered print()/log() output to std::cout and flushes it
+inline void flush() {
+    internal::lps_out().hand_over();
+    std::cout.flush();
 }
-// Base case for the recursive calls
-inline zen::string to_string() { return ""; }
 
-// ------------------------------------------------------------------------------------------ print
+// ------------------------------------------------------------------------------------------ stringify
 
-// Function to handle individual item printing
-template <class T>
-void print(const T& x)
-{
-    std::cout << to_string(x);
+namespace internal {
+    // Numbers as a default-formatted std::ostream shows them, without one
+    template<class T>
+    void append_scalar(std::string& out, const T& x) {
+        if constexpr (std::is_same_v<T, bool>) {
+            out += x ? '1' : '0';
+        } else if constexpr (std::is_same_v<T, char> || std::is_same_v<T, signed char> || std::is_same_v<T, unsigned char>) {
+            out += static_cast<char>(x);
+        } else if constexpr (std::is_integral_v<T> && !std::is_same_v<T, wchar_t>
+                          && !std::is_same_v<T, char16_t> && !std::is_same_v<T, char32_t>) {
+            char buf[24];
+            const auto r = std::to_chars(buf, buf + sizeof buf, x);
+            out.append(buf, r.ptr);
+        } else if constexpr (std::is_floating_point_v<T>) {
+            char buf[64];
+#if defined(__cpp_lib_to_chars)
+            const auto r = std::to_chars(buf, buf + sizeof buf, x, std::chars_format::general, 6); // = %g
+            out.append(buf, r.ptr);
+#else
+            const int n = std::is_same_v<T, long double> ? std::snprintf(buf, sizeof buf, "%Lg", static_cast<long double>(x))
+                                                         : std::snprintf(buf, sizeof buf, "%g",  static_cast<double>(x));
+            out.append(buf, static_cast<std::size_t>(std::max(n, 0)));
+#endif
+        } else {                                // anything else with an operator<<
+            thread_local std::ostringstream os;
+            os.str(std::string());
+            os.clear();
+            os << x;
+            out += os.str();
+        }
+    }
+
+    template<class T>
+    void append(std::string& out, const T& x) {
+        // First check for string-likeness so that zen::pring("abc") prints "abc"
+        // and not [a, b, c] as a result of considering strings as iterable below
+        if constexpr (is_string_like<T>()) {
+            if constexpr (std::is_convertible_v<const T&, std::string_view>)
+                out += std::string_view(x);
+            else
+                out += std::string(x);
+        } else if constexpr (is_iterable_v<T>) {
+            out += '[';
+            for (auto it = std::begin(x); it != std::end(x); ++it) {
+                if (it != std::begin(x))
+                    out += ", ";
+                if constexpr (is_string_like<decltype(*it)>()) {
+                    out += '"';
+                    append(out, *it);
+                    out += '"';
+                } else {
+                    append(out, *it);           // recursive call to handle nested iterables
+                }
+            }
+            out += ']';
+        } else { // not iterable, single item
+            append_scalar(out, x);
+        }
+    }
+
+    // The items, separated by spaces
+    template<class T, class... Args>
+    void append_all(std::string& out, const T& x, const Args&... args) {
+        append(out, x);
+        ((out += ' ', append(out, args)), ...);
+    }
+    inline void append_all(std::string&) {}
+} // namespace internal
+
+// Converts most of the widely used data types to a string.
+// Example: std::vector<int> v = {1, 3, 3};
+// Example: to_string(vec) Result: [1, 2, 3]
+// Example: to_string(42)  Result: "42"
+// Several arguments are joined by spaces: to_string("n =", 42) Result: "n = 42"
+template<class... Args>
+zen::string to_string(const Args&... args) {
+    zen::string s;
+    internal::append_all(s, args...);
+    return s;
 }
 
+// ------------------------------------------------------------------------------------------ print
+
 // Generic, almost Python-like print(). Works like this:
 // print("Hello", "World", vec, 42); // Output: Hello World [1, 2, 3] 42
 // print("Hello", "World", 24, vec); // Output: Hello World 24 [1, 2, 3]
 // print("Hello", vec, 42, "World"); // Output: Hello [1, 2, 3] 42 World
-template <class T, class... Args>
-void print(T x, Args... args) {
-    print(x);
-    if constexpr (sizeof...(args) != 0) {
-        std::cout << " ";
-    }
-    print(args...);
+template <class... Args>
+void print(const Args&... args) {
+    auto& out = internal::lps_out();
+    internal::append_all(out.text, args...);
+    out.done(false);
 }
-// Base case for the recursive calls
-inline void print() {}
 
 // ------------------------------------------------------------------------------------------ log
 
-// Handles logging a single item
-template <class T>
-void log(const T& x)
-{
-    print(x, '\n');
+// Generic, almost Python-like log(). Works like print() but ends the line;
+// whether that also flushes std::cout is up to the flush_policy
+template <class... Args>
+void log(const Args&... args) {
+    if constexpr (sizeof...(args) == 0)
+        return;                                 // as before: nothing to log, no empty line
+    auto& out = internal::lps_out();
+    internal::append_all(out.text, args...);
+    out.text += '\n';
+    out.done(true);
 }
 
-// Generic, almost Python-like log(). Works similar to the print() function but adds std::endl
-template <class T, class... Args>
-void log(T x, Args... args) {
-    print(x, args...);
-    std::cout << std::endl;
-}
-// Base case for the recursive calls
-inline void log() {}
+// ------------------------------------------------------------------------------------------ async_log
+
+// Log sink for many threads.  log() formats a line and copies it into a
+// preallocated slot of a bounded lock-free ring (sequence-numbered slots,
+// many producers, one consumer); a background thread gathers ready slots
+// into one write() per batch.  Lines longer than a slot are cut short.
+// Writing to stdout bypasses std::cout, so the two do not keep each
+// other's order.
+// Usage:
+// zen::async_log alog("run.log");                  // "" = stdout
+// alog.flush_on_signals();                         // also write what is queued on a crash
+// alog.log("worker", id, "took", ns, "ns");        // from any thread
+class async_log {
+public:
+    // What log() does when every slot is taken
+    enum class overflow {
+        drop,   // discard the line; dropped() counts it
+        block,  // wait for the writer to free a slot
+        count,  // discard it, and the writer notes "N lines dropped" in the output
+    };
+
+    explicit async_log(const std::filesystem::path& path = {}, overflow when_full = overflow::count,
+                       std::size_t slots = 4096, std::size_t slot_bytes = 256)
+        : when_full_(when_full), slot_bytes_(std::max<std::size_t>(slot_bytes, 16))
+    {
+        std::size_t n = 1;
+        while (n < slots)
+            n <<= 1;
+        mask_  = n - 1;
+        slots_ = std::make_unique<slot[]>(n);
+        text_  = std::make_unique<char[]>(n * slot_bytes_);
+        for (std::size_t i = 0; i < n; ++i)
+            slots_[i].seq.store(i, std::memory_order_relaxed);
+
+        if (!path.empty()) {
+#if ZEN_HAS_POSIX
+            fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+            if (fd_ < 0)
+#else
+            file_ = std::fopen(path.string().c_str(), "ab");
+            if (!file_)
+#endif
+                throw std::runtime_error("ERROR OPENING FILE: " + zen::quote(path.string()));
+        }
+        writer_ = std::thread([this] { run(); });
+    }
+
+    // Writes out everything queued, then stops the writer
+    ~async_log() {
+        stop_.store(true, std::memory_order_release);
+        writer_.join();
+#if ZEN_HAS_POSIX
+        async_log* self = this;
+        signal_target().compare_exchange_strong(self, nullptr);
+        if (fd_ != STDOUT_FILENO)
+            ::close(fd_);
+#else
+        if (file_ != stdout)
+            std::fclose(file_);
+#endif
+    }
+
+    async_log(const async_log&)            = delete;
+    async_log& operator=(const async_log&) = delete;
+
+    // Items are separated by spaces and the line ends with '\n', as with
+    // zen::log(); false if the line was dropped
+    template<class... Args>
+    bool log(const Args&... args) {
+        thread_local std::string line;
+        line.clear();
+        internal::append_all(line, args...);
+        line += '\n';
+        return push(line);
+    }
+
+    // Returns once every line logged before the call has been written
+    void flush() const {
+        const std::size_t target = head_.load(std::memory_order_acquire);
+        while (tail_.load(std::memory_order_acquire) < target)
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+
+    // Lines lost to a full ring so far
+    std::uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+#if ZEN_HAS_POSIX
+    // On these signals, writes whatever is queued straight from the handler
+    // (async-signal-safe: atomics and write() only), then passes the signal
+    // on to the handler that was there before, or to the default action.
+    // One log at a time can be the target: a later call, from any log,
+    // only retargets the signals that are hooked already.
+    void flush_on_signals(std::initializer_list<int> signals = { SIGABRT, SIGBUS, SIGFPE, SIGILL, SIGSEGV, SIGTERM }) {
+        signal_target().store(this, std::memory_order_release);
+        for (int sig : signals) {
+            if (sig <= 0 || sig >= MAX_SIGNAL)
+                continue;
+            struct sigaction now {};
+            if (::sigaction(sig, nullptr, &now) == 0 && (now.sa_flags & SA_SIGINFO) && now.sa_sigaction == on_signal)
+                continue;                              // chaining to ourselves would never end
+            struct sigaction sa {};
+            sa.sa_sigaction = on_signal;
+            sa.sa_flags     = SA_SIGINFO | SA_ONSTACK;
+            sigemptyset(&sa.sa_mask);
+            ::sigaction(sig, &sa, &previous()[sig]);
+        }
+    }
+#endif
+
+private:
+    struct slot {
+        std::atomic<std::size_t> seq{ 0 };   // == position: free, position + 1: ready
+        std::uint32_t            len = 0;
+    };
+
+    char* text_of(std::size_t pos) const { return text_.get() + (pos & mask_) * slot_bytes_; }
+
+    bool push(const std::string& line) {
+        std::size_t pos = head_.load(std::memory_order_relaxed);
+        for (;;) {
+            slot& s = slots_[pos & mask_];
+            const auto diff = static_cast<std::ptrdiff_t>(s.seq.load(std::memory_order_acquire) - pos);
+            if (diff == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            } else if (diff < 0) {                      // full: the slot still holds last lap's line
+                if (when_full_ != overflow::block) {
+                    dropped_.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+                std::this_thread::yield();
+                pos = head_.load(std::memory_order_relaxed);
+            } else {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+        slot& s = slots_[pos & mask_];
+        const std::size_t len = std::min(line.size(), slot_bytes_);
+        std::memcpy(text_of(pos), line.data(), len);
+        if (len < line.size())
+            text_of(pos)[len - 1] = '\n';              // cut short, still one line
+        s.len = static_cast<std::uint32_t>(len);
+        s.seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    void write_all(const char* p, std::size_t n) const {
+#if ZEN_HAS_POSIX
+        while (n > 0) {
+            const ssize_t w = ::write(fd_, p, n);
+            if (w < 0 && errno == EINTR)
+                continue;
+            if (w <= 0)
+                return;
+            p += w;
+            n -= static_cast<std::size_t>(w);
+        }
+#else
+        std::fwrite(p, 1, n, file_);
+        std::fflush(file_);
+#endif
+    }
+
+    // Slots stay taken until their batch is written, so a handler that
+    // takes over from a stuck writer loses nothing (it may repeat a little)
+    void run() {
+        std::string   batch;
+        std::uint64_t reported = 0;
+        batch.reserve(BATCH_BYTES + slot_bytes_);
+        for (;;) {
+            const bool  stopping = stop_.load(std::memory_order_acquire);
+            int         idle     = CONSUMER_IDLE;
+            if (!consumer_.compare_exchange_strong(idle, CONSUMER_WRITER, std::memory_order_acquire)) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));   // a handler is draining
+                continue;
+            }
+            const std::size_t begin = tail_.load(std::memory_order_relaxed);
+            std::size_t       pos   = begin;
+            while (batch.size() < BATCH_BYTES && pos - begin <= mask_) {
+                const slot& s = slots_[pos & mask_];
+                if (s.seq.load(std::memory_order_acquire) != pos + 1)
+                    break;
+                batch.append(text_of(pos), s.len);
+                ++pos;
+            }
+            if (when_full_ == overflow::count) {
+                const std::uint64_t d = dropped_.load(std::memory_order_relaxed);
+                if (d != reported) {
+                    batch += "[async_log] " + std::to_string(d - reported) + " lines dropped\n";
+                    reported = d;
+                }
+            }
+            write_all(batch.data(), batch.size());
+            batch.clear();
+            for (std::size_t p = begin; p < pos; ++p)
+                slots_[p & mask_].seq.store(p + mask_ + 1, std::memory_order_release);
+            tail_.store(pos, std::memory_order_release);
+            consumer_.store(CONSUMER_IDLE, std::memory_order_release);
+
+            if (pos == begin) {
+                if (stopping)
+                    break;
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+            }
+        }
+    }
+
+#if ZEN_HAS_POSIX
+    static constexpr int MAX_SIGNAL = 65;
+
+    static std::atomic<async_log*>& signal_target() {
+        static std::atomic<async_log*> target{ nullptr };
+        return target;
+    }
+
+    static struct sigaction* previous() {
+        static struct sigaction actions[MAX_SIGNAL];
+        return actions;
+    }
+
+    // Handler side of run(): slot text goes to write() as is, nothing is allocated
+    void drain_from_handler() noexcept {
+        for (long spin = 0; ; ++spin) {                // give a running batch time to finish
+            int idle = CONSUMER_IDLE;
+            if (consumer_.compare_exchange_strong(idle, CONSUMER_HANDLER, std::memory_order_acquire))
+                break;
+            if (spin > (1L << 22)) {                   // the writer is stuck, or it is us
+                consumer_.store(CONSUMER_HANDLER, std::memory_order_release);
+                break;
+            }
+        }
+        std::size_t pos = tail_.load(std::memory_order_acquire);
+        for (;; ++pos) {
+            slot& s = slots_[pos & mask_];
+            if (s.seq.load(std::memory_order_acquire) != pos + 1)
+                break;
+            write_all(text_of(pos), s.len);
+            s.seq.store(pos + mask_ + 1, std::memory_order_release);
+        }
+        tail_.store(pos, std::memory_order_release);
+        consumer_.store(CONSUMER_IDLE, std::memory_order_release);
+    }
+
+    static void on_signal(int sig, siginfo_t* info, void* context) {
+        const int saved = errno;
+        if (async_log* self = signal_target().load(std::memory_order_acquire))
+            self->drain_from_handler();
+
+        struct sigaction& prev = previous()[sig];
+        errno = saved;
+        if (prev.sa_flags & SA_SIGINFO) {
+            if (prev.sa_sigaction)
+                prev.sa_sigaction(sig, info, context);
+        } else if (prev.sa_handler == SIG_IGN) {
+            return;
+        } else if (prev.sa_handler != SIG_DFL && prev.sa_handler) {
+            prev.sa_handler(sig);
+        } else {                                       // default action, as if we were never here
+            ::sigaction(sig, &prev, nullptr);
+            ::raise(sig);
+        }
+    }
+#endif
+
+    static constexpr std::size_t BATCH_BYTES      = std::size_t(1) << 16;
+    static constexpr int         CONSUMER_IDLE    = 0;
+    static constexpr int         CONSUMER_WRITER  = 1;
+    static constexpr int         CONSUMER_HANDLER = 2;
+
+    overflow                     when_full_;
+    std::size_t                  slot_bytes_;
+    std::size_t                  mask_ = 0;
+    std::unique_ptr<slot[]>      slots_;
+    std::unique_ptr<char[]>      text_;
+    alignas(64) std::atomic<std::size_t>   head_{ 0 };       // next position producers claim
+    alignas(64) std::atomic<std::size_t>   tail_{ 0 };       // next position the writer takes
+    std::atomic<std::uint64_t>   dropped_{ 0 };
+    std::atomic<int>             consumer_{ CONSUMER_IDLE };  // who may take slots right now
+    std::atomic<bool>            stop_{ false };
+#if ZEN_HAS_POSIX
+    int                          fd_   = STDOUT_FILENO;
+#else
+    std::FILE*                   file_ = stdout;
+#endif
+    std::thread                  writer_;
+};
 
 ///////////////////////////////////////////////////////////////////////////////////////////// COMPOSITES
 
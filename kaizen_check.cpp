@@ -0,0 +1,52 @@
+// kaizen_check — consistency checks for the parts of kaizen.h whose
+// results must not depend on how they are run.  Exit status 0 = all
+// passed, 1 = something disagreed (details on stderr).
+
+#include "kaizen.h"
+
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <vector>
+
+static int FAILED = 0;
+
+static void expect(bool ok, const char* what)
+{
+    if (!ok) {
+        std::fprintf(stderr, "[check] FAILED: %s\n", what);
+        ++FAILED;
+    }
+}
+
+// n copies of 0.1f: naive float summation is off by percent here, Kahan
+// must land on the exact value under every policy, and they must agree
+static void kahan_agrees(std::size_t n)
+{
+    const std::vector<float> v(n, 0.1f);
+    const double exact = static_cast<double>(0.1f) * static_cast<double>(n);
+    const float  s  = zen::sum(zen::execution::seq,       v, zen::summation::kahan);
+    const float  p  = zen::sum(zen::execution::par,       v, zen::summation::kahan);
+    const float  pu = zen::sum(zen::execution::par_unseq, v, zen::summation::kahan);
+    std::printf("[check] kahan n=%zu: seq %.4f  par %.4f  par_unseq %.4f  exact %.4f\n",
+                n, static_cast<double>(s), static_cast<double>(p), static_cast<double>(pu), exact);
+
+    const double tol = 2 * static_cast<double>(std::numeric_limits<float>::epsilon()) * exact;
+    expect(std::fabs(s  - exact) <= tol, "seq kahan sum of 0.1f is exact to 2 ulp");
+    expect(std::fabs(p  - exact) <= tol, "par kahan sum of 0.1f is exact to 2 ulp");
+    expect(std::fabs(pu - exact) <= tol, "par_unseq kahan sum of 0.1f is exact to 2 ulp");
+}
+
+int main()
+{
+    kahan_agrees(1000000);
+    kahan_agrees(10000000);
+
+    // Integer sums take the plain path under every policy
+    const std::vector<unsigned> u = { 1, 2, 3 };
+    expect(zen::sum(zen::execution::seq, u) == 6u, "seq sum of unsigned");
+    expect(zen::sum(zen::execution::par_unseq, u, zen::summation::kahan) == 6u, "kahan ignored for unsigned");
+
+    std::printf("[check] %s\n", FAILED ? "FAILED" : "all passed");
+    return FAILED ? 1 : 0;
+}
@@ -1,4 +1,5 @@
 #include "kernel_access.h"
+#include "trial_trace.h"
 #include <iostream>
 
 [[noreturn]] void run_kernel_access(std::uint64_t address, bool verbose)
@@ -10,6 +11,7 @@
     volatile std::uint32_t *ptr =
         reinterpret_cast<volatile std::uint32_t *>(address);
 
+    trace_begin(TracePhase::TrapEntry);
     *ptr = 0xDEADBEEF;                   // -> page‑fault in user mode
     std::cout << "Should never get here\n";
     std::exit(EXIT_FAILURE);             // placate compilers
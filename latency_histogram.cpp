@@ -0,0 +1,49 @@
+#include "latency_histogram.h"
+#include <algorithm>
+
+void LatencyHistogram::add(std::uint64_t v)
+{
+    ++bins_[bin_of(v)];
+    ++count_;
+    sum_ += v;
+    min_  = std::min(min_, v);
+    max_  = std::max(max_, v);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& h)
+{
+    for (int i = 0; i < BINS; ++i) bins_[i] += h.bins_[i];
+    count_ += h.count_;
+    sum_   += h.sum_;
+    min_    = std::min(min_, h.min_);
+    max_    = std::max(max_, h.max_);
+}
+
+std::uint64_t LatencyHistogram::quantile(double q) const
+{
+    if (count_ == 0) return 0;
+    const auto rank = static_cast<std::uint64_t>(q * static_cast<double>(count_ - 1)) + 1;
+    std::uint64_t seen = 0;
+    for (int i = 0; i < BINS; ++i) {
+        seen += bins_[i];
+        if (seen >= rank)
+            return std::clamp((lower_of(i) + lower_of(i + 1)) / 2, min_, max_);
+    }
+    return max_;
+}
+
+int LatencyHistogram::bin_of(std::uint64_t v)
+{
+    if (v < SUB) return static_cast<int>(v);
+    int msb = 63;
+    while (!(v >> msb)) --msb;
+    return (msb - 2) * SUB + static_cast<int>((v >> (msb - 3)) & (SUB - 1));
+}
+
+std::uint64_t LatencyHistogram::lower_of(int b)
+{
+    if (b < SUB) return static_cast<std::uint64_t>(b);
+    const int msb = b / SUB + 2;
+    if (msb > 63) return ~std::uint64_t(0);
+    return static_cast<std::uint64_t>(SUB + b % SUB) << (msb - 3);
+}
@@ -0,0 +1,37 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <array>
+#include <cstdint>
+
+/**
+ * Log-linear latency histogram: 8 sub-buckets per power of two, i.e.
+ * ~6 % resolution over the full 64-bit range in 512 fixed counters.
+ * Memory stays constant however many samples go in, so it serves both
+ * the probe daemon's time ring and streaming analysis of huge CSVs.
+ */
+class LatencyHistogram {
+public:
+    static constexpr int SUB  = 8;
+    static constexpr int BINS = 64 * SUB;
+
+    void add(std::uint64_t v);
+    void merge(const LatencyHistogram& h);
+
+    /** Midpoint of the bin holding quantile q in [0, 1], 0 when empty. */
+    std::uint64_t quantile(double q) const;
+
+    std::uint64_t count() const { return count_; }
+    std::uint64_t sum()   const { return sum_; }
+    std::uint64_t min()   const { return count_ ? min_ : 0; }
+    std::uint64_t max()   const { return max_; }
+
+private:
+    static int           bin_of(std::uint64_t v);
+    static std::uint64_t lower_of(int bin);
+
+    std::array<std::uint64_t, BINS> bins_{};
+    std::uint64_t count_ = 0, sum_ = 0, max_ = 0;
+    std::uint64_t min_   = ~std::uint64_t(0);
+};
+#endif // LATENCY_HISTOGRAM_H
@@ -2,150 +2,413 @@
 #   define _CRT_SECURE_NO_WARNINGS        // silence MSVC CRT warnings
 #endif
 
+#include "corunner.h"
+#include "crash_guard.h"
+#include "fault_ring.h"
 #include "heap_overflow.h"
+#include "host_info.h"
 #include "kernel_access.h"
+#include "malloc_corrupt.h"
+#include "probe_daemon.h"
+#include "redzone.h"
+#include "replay.h"
+#include "shootdown.h"
+#include "stack_guard.h"
+#include "stats.h"
+#include "trial_trace.h"
 #include "kaizen.h"
 
-#include <csignal>
+#include <algorithm>
+#include <charconv>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
-#include <functional>
 #include <fstream>
+#include <functional>
 #include <iomanip>
 #include <iostream>
+#include <map>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <vector>
 
-#if defined(_WIN32)            // -------- Windows : ISO setjmp/longjmp
-    #include <setjmp.h>
-    static jmp_buf JUMP_BUF;
-    #define SETJMP(env)    setjmp(env)
-    #define LONGJMP(env,v) longjmp(env,v)
-    #include <windows.h>
-    #include <eh.h>                 // _set_se_translator
-#else                              // -------- POSIX : sigsetjmp/siglongjmp
-    #include <csetjmp>
-    static sigjmp_buf JUMP_BUF;
-    #define SETJMP(env)    sigsetjmp(env,1)
-    #define LONGJMP(env,v) siglongjmp(env,v)
-#endif
+// Command-line argument parsing structure
+struct Opt {
+    enum class Which { Heap, Kernel, Both } test = Which::Both;
+    int trials = 3;
+    std::vector<std::size_t> allocs = { 16 };   // several values = sweep
+    std::size_t over = 1024;
+    std::uint64_t addr = 0xFFFF000000000000ULL;
+    int  cpu = -1;                  // pin to this CPU (-1 = don't pin)
+    bool discard_disturbed = false; // drop trials hit by scheduler noise
 
-// Run result structure
-struct RunResult { bool crashed{}; long long ns{}; };
+    // glibc heap-corruption detection next to the guard-page test
+    bool          malloc_corrupt = false;
+    CorruptTarget corrupt_target = CorruptTarget::Size;
+    std::size_t   corrupt_bytes  = 8;       // bytes past the usable end of the chunk (tcache: 16)
+    long long     malloc_ops     = 100000;  // malloc/free calls before giving up
 
-// Handler for segmentation fault signal
-void segv_handler(int) { LONGJMP(JUMP_BUF, 1); }
+    std::vector<Load> loads = { Load::Idle };   // co-runner profiles, run in turn
+    std::vector<int>  load_cpus;                // "" = every CPU but --cpu
 
-// Function to run the tests with a guard against crashes
-RunResult run_with_guard(const std::function<void()>& fn)
-{
-    zen::timer t;
-    RunResult r;
-
-#if defined(_WIN32)  // SEH for Windows
-    if (SETJMP(JUMP_BUF) == 0) {
-        __try {
-            t.start();
-            fn();
-            t.stop();
-            r.crashed = false;
-        }
-        __except(EXCEPTION_EXECUTE_HANDLER) {
-            t.stop();
-            r.crashed = true;
-            std::cerr << "Access violation occurred (SEH)\n";
-        }
-    } else {
-        t.stop();
-        r.crashed = true;
-    }
-#else  // ---------- POSIX ------------------------------
-    std::signal(SIGSEGV, segv_handler);
-    std::signal(SIGABRT, segv_handler);   // ← NEW: catch allocator aborts
-
-    if (SETJMP(JUMP_BUF) == 0) {
-        t.start();
-        fn();                 // may smash the heap
-        t.stop();
-        r.crashed = false;
-    } else {
-        t.stop();
-        r.crashed = true;     // we jumped back from SIGSEGV or SIGABRT
-    }
+    // Sequential stopping: 0 = off, run exactly `trials`
+    double target_ci   = 0.0;       // relative 95 % CI half-width, e.g. 0.01
+    bool   ci_median   = false;     // judge the median instead of the mean
+    int    min_trials  = 10;
+    int    max_trials  = 10000;
+    int    batch       = 10;
+    double budget_s    = 60.0;      // wall-clock cap per load profile, --target-ci only
 
-    // restore defaults
-    std::signal(SIGSEGV, SIG_DFL);
-    std::signal(SIGABRT, SIG_DFL);
-#endif                             
+    std::string trace_file;         // Chrome trace-event JSON ("" = off)
+    std::string fault_log;          // every fault the handlers saw, as CSV ("" = off)
 
-    r.ns = t.duration<zen::timer::nsec>().count();
-    return r;
-}                              
+    std::string  daemon_socket;     // run as probe daemon on this socket ("" = off)
+    DaemonConfig daemon;
 
+    bool            shootdown = false;  // run the TLB-shootdown sweep instead
+    ShootdownConfig shoot;
 
-// Command-line argument parsing structure
-struct Opt {
-    enum class Which { Heap, Kernel, Both } test = Which::Both;
-    int trials = 3;
-    std::size_t alloc = 16, over = 1024;
-    std::uint64_t addr = 0xFFFF000000000000ULL;
+    bool          redzone = false;      // run the red-zone vs. guard-page comparison instead
+    RedZoneConfig rz;
+
+    ReplayConfig    replay;             // replay a recorded trace instead ("" = off)
+    ReplayGenConfig replay_gen;         // write a synthetic trace instead ("" = off)
+
+    bool             stack_guard = false;   // run the thread-stack guard sweep instead
+    StackGuardConfig stack;
 };
 
+// Accepts "1%" or "0.01": a bare number is always a fraction, and anything
+// outside [0, 1] is rejected rather than guessed at
+static double parse_ratio(const std::string& s)
+{
+    const bool   pct = !s.empty() && s.back() == '%';
+    const double v   = std::stod(s) / (pct ? 100.0 : 1.0);
+    if (!(v >= 0.0 && v <= 1.0))
+        throw std::invalid_argument("'" + s + "' is not a ratio: use a fraction (0.01) or a percentage (1%)");
+    return v;
+}
+
+static void describe(zen::cmd_args& a)
+{
+    a.accept("--test",              "heap|kernel|both",  "guard-page test to run (both)")
+     .accept("--trials",            "N",                 "trials per test (3)")
+     .accept("--alloc",             "BYTES,...",         "heap allocation sizes, several = sweep (16)")
+     .accept("--overrun",           "BYTES",             "bytes written past the allocation (1024)")
+     .accept("--addr",              "HEX",               "kernel address to touch (FFFF000000000000)")
+     .accept("--cpu",               "N",                 "pin to this CPU")
+     .accept("--discard-disturbed", "",                  "drop trials hit by scheduler noise")
+     .accept("--malloc-corrupt",    "size|tcache",       "also run glibc heap-corruption detection")
+     .accept("--corrupt-bytes",     "BYTES",             "bytes past the usable end of the chunk (size 8, tcache 16)")
+     .accept("--malloc-ops",        "N",                 "malloc/free calls before giving up (100000)")
+     .accept("--load",              "PROFILE,...",       "co-runners: idle,stream,tlb,mmap,syscall (idle)")
+     .accept("--load-cpus",         "N,...",             "CPUs for the co-runners (all but --cpu)")
+     .accept("--target-ci",         "P%",                "sample until the 95 % CI is this tight (off)")
+     .accept("--ci-stat",           "mean|median",       "statistic --target-ci judges (mean)")
+     .accept("--min-trials",        "N",                 "sequential stopping: at least (10)")
+     .accept("--max-trials",        "N",                 "sequential stopping: at most (10000)")
+     .accept("--batch",             "N",                 "trials between CI checks (10)")
+     .accept("--budget",            "SEC",               "sequential stopping: wall-clock cap per load profile (60)")
+     .accept("--trace",             "FILE.json",         "Chrome trace-event output")
+     .accept("--fault-log",         "FILE.csv",          "every fault the handlers saw")
+     .accept("--daemon",            "SOCKET",            "run as probe daemon")
+     .accept("--duty",              "P%",                "daemon: max share of time spent probing (0.1%)")
+     .accept("--bucket-seconds",    "N",                 "daemon: seconds per histogram bucket (10)")
+     .accept("--buckets",           "N",                 "daemon: buckets of history (60)")
+     .accept("--shootdown",         "[N,...]",           "TLB-shootdown sweep over these thread counts")
+     .accept("--ops",               "OP,...",            "shootdown: mprotect,munmap,madvise")
+     .accept("--iters",             "N",                 "shootdown / red-zone iterations")
+     .accept("--region-pages",      "N",                 "shootdown: pages the workers touch (64)")
+     .accept("--spin",              "",                  "shootdown: workers spin instead of touching")
+     .accept("--stack-guard",       "[BYTES,...]",       "thread-stack guard sweep over these guard sizes")
+     .accept("--stack-size",        "BYTES",             "stack guard: thread stack size (256K)")
+     .accept("--spawn",             "N,...",             "stack guard: threads spawned per point (100,1000)")
+     .accept("--redzone",           "[BYTES,...]",       "red-zone vs. guard-page comparison over these sizes")
+     .accept("--live",              "N",                 "red-zone / replay-gen: blocks kept live")
+     .accept("--replay",            "TRACE",             "replay a recorded allocation trace")
+     .accept("--guard",             "STRATEGY,...",      "replay: page,page-end,none (all)")
+     .accept("--threads",           "N",                 "replay: workers (one per shard)")
+     .accept("--replay-gen",        "TRACE",             "write a synthetic trace")
+     .accept("--events",            "N",                 "replay-gen: events (1000000)")
+     .accept("--shards",            "N",                 "replay-gen: shards (4)")
+     .accept("--overrun-rate",      "P%",                "replay-gen: writes that overrun (0.1%)");
+}
+
 Opt parse(int argc, char** argv)
 {
     zen::cmd_args a(argv, argc);
+    describe(a);
     Opt o;
     if (a.is_present("--help") || a.is_present("-h")) {
         std::cout << "Usage: " << argv[0] << " --test [heap|kernel|both] "
-                  << "[--trials N] [--alloc N] [--overrun N] [--addr HEX]\n";
+                  << "[--trials N] [--alloc N [N ...]] [--overrun N] [--addr HEX] "
+                  << "[--cpu N] [--discard-disturbed]\n"
+                  << "       [--malloc-corrupt size|tcache] [--corrupt-bytes N] [--malloc-ops N]\n"
+                  << "       [--load idle,stream,tlb,mmap,syscall] [--load-cpus N,N,...]\n"
+                  << "       [--target-ci P%] [--ci-stat mean|median] [--min-trials N] "
+                  << "[--max-trials N] [--batch N] [--budget SEC]\n"
+                  << "       [--trace FILE.json] [--fault-log FILE.csv]\n"
+                  << "       " << argv[0] << " --daemon SOCKET [--duty P%] [--bucket-seconds N] "
+                  << "[--buckets N] [--alloc N] [--overrun N] [--addr HEX]\n"
+                  << "       " << argv[0] << " --shootdown [N,N,...] [--ops mprotect,munmap,madvise] "
+                  << "[--iters N] [--region-pages N] [--spin] [--cpu N]\n"
+                  << "       " << argv[0] << " --stack-guard [BYTES,...] [--stack-size BYTES] "
+                  << "[--spawn N,N,...] [--trials N]\n"
+                  << "       " << argv[0] << " --redzone [BYTES,...] [--iters N] [--live N] [--trials N]\n"
+                  << "       " << argv[0] << " --replay TRACE [--guard page,page-end,none] [--threads N]\n"
+                  << "       " << argv[0] << " --replay-gen TRACE [--events N] [--shards N] [--live N] "
+                  << "[--overrun-rate P%]\n"
+                  << "Sizes take K/M/G suffixes (64K, 1M); integers may be hex (0x1000).\n\n"
+                  << "Options:\n" << a.help();
         std::exit(0);
     }
-    if (a.is_present("--test")) {
-        std::string t = a.get_options("--test")[0];
+
+    try {
+        const std::string t = a.get<std::string>("--test");
         if (t == "heap")   o.test = Opt::Which::Heap;
         else if (t == "kernel") o.test = Opt::Which::Kernel;
+
+        o.trials = a.get("--trials", o.trials);
+        if (a.is_present("--alloc")) o.allocs = a.get_all<std::size_t>("--alloc");
+        if (o.allocs.empty()) o.allocs = { 16 };
+        o.over = a.get("--overrun", o.over);
+        if (a.is_present("--addr")) {                   // hex, with or without 0x
+            std::string_view v = a.get<std::string_view>("--addr");
+            if (v.size() > 2 && v[0] == '0' && (v[1] == 'x' || v[1] == 'X')) v.remove_prefix(2);
+            const auto r = std::from_chars(v.data(), v.data() + v.size(), o.addr, 16);
+            if (r.ec != std::errc() || r.ptr != v.data() + v.size())
+                throw std::invalid_argument("INVALID VALUE FOR \"--addr\": " + zen::quote(std::string(v)));
+        }
+        o.cpu = a.get("--cpu", o.cpu);
+        o.discard_disturbed = a.is_present("--discard-disturbed");
+
+        if (a.is_present("--malloc-corrupt")) {
+            o.malloc_corrupt = true;
+            const auto t = a.options("--malloc-corrupt");
+            if (!t.empty() && !parse_corrupt_target(std::string(t[0]), o.corrupt_target))
+                std::cerr << "[warn] unknown corruption target '" << t[0] << "', using size\n";
+        }
+        // size + tcache next of a freed chunk lie 16 bytes past A's usable end
+        o.corrupt_bytes = a.get("--corrupt-bytes", o.corrupt_target == CorruptTarget::Tcache
+                                                     ? std::size_t(16) : o.corrupt_bytes);
+        o.malloc_ops    = a.get("--malloc-ops",    o.malloc_ops);
+
+        // Both "--load a,b" and "--load a b" are accepted
+        if (a.is_present("--load")) {
+            o.loads.clear();
+            for (const auto& v : a.get_all<std::string>("--load")) {
+                Load l;
+                if (parse_load(v, l)) o.loads.push_back(l);
+                else std::cerr << "[warn] unknown load profile '" << v << "' ignored\n";
+            }
+            if (o.loads.empty()) o.loads.push_back(Load::Idle);
+        }
+        o.load_cpus = a.get_all<int>("--load-cpus");
+
+        if (a.is_present("--target-ci")) o.target_ci = parse_ratio(a.get<std::string>("--target-ci"));
+        if (a.is_present("--ci-stat"))   o.ci_median = a.get<std::string_view>("--ci-stat") == "median";
+        o.min_trials = a.get("--min-trials", o.min_trials);
+        o.max_trials = a.get("--max-trials", o.max_trials);
+        o.batch      = std::max(a.get("--batch", o.batch), 1);
+        o.budget_s   = a.get("--budget",    o.budget_s);
+        if (a.is_present("--budget") && o.target_ci <= 0.0)
+            std::cerr << "[warn] --budget only applies with --target-ci, ignored\n";
+        o.trace_file = a.get("--trace",     o.trace_file);
+        o.fault_log  = a.get("--fault-log", o.fault_log);
+
+        o.daemon_socket = a.get("--daemon", o.daemon_socket);
+        if (a.is_present("--duty")) o.daemon.duty = parse_ratio(a.get<std::string>("--duty"));
+        o.daemon.bucket_seconds = a.get("--bucket-seconds", o.daemon.bucket_seconds);
+        o.daemon.buckets        = a.get("--buckets",        o.daemon.buckets);
+        if (a.is_present("--shootdown")) {
+            o.shootdown     = true;
+            o.shoot.threads = a.get_all<int>("--shootdown");
+        }
+        if (a.is_present("--ops")) o.shoot.ops = a.get_all<std::string>("--ops");
+        for (const auto& op : o.shoot.ops)
+            if (!is_shootdown_op(op))
+                throw std::invalid_argument("unknown --ops value '" + op + "'");
+        o.shoot.iters        = a.get("--iters",        o.shoot.iters);
+        o.shoot.region_pages = a.get("--region-pages", o.shoot.region_pages);
+        o.shoot.spin = a.is_present("--spin");
+        o.shoot.cpu  = o.cpu;
+
+        if (a.is_present("--stack-guard")) {
+            o.stack_guard = true;
+            const auto sizes = a.get_all<std::size_t>("--stack-guard");
+            if (!sizes.empty()) o.stack.guards = sizes;
+        }
+        if (a.is_present("--redzone")) {
+            o.redzone = true;
+            const auto sizes = a.get_all<std::size_t>("--redzone");
+            if (!sizes.empty()) o.rz.sizes = sizes;
+        }
+        if (a.is_present("--iters"))  o.rz.iters  = o.shoot.iters;
+        o.rz.live = a.get("--live", o.rz.live);
+        if (a.is_present("--trials")) o.rz.trials = o.trials;
+
+        o.replay.file    = a.get("--replay",  o.replay.file);
+        o.replay.threads = a.get("--threads", o.replay.threads);
+        if (a.is_present("--guard")) {
+            o.replay.guards.clear();
+            for (const auto& v : a.get_all<std::string>("--guard")) {
+                ReplayGuard g;
+                if (parse_replay_guard(v, g)) o.replay.guards.push_back(g);
+                else std::cerr << "[warn] unknown guard strategy '" << v << "' ignored\n";
+            }
+        }
+        o.replay_gen.file   = a.get("--replay-gen", o.replay_gen.file);
+        o.replay_gen.events = a.get("--events",     o.replay_gen.events);
+        o.replay_gen.shards = a.get("--shards",     o.replay_gen.shards);
+        if (a.is_present("--live")) o.replay_gen.live = o.rz.live;
+        if (a.is_present("--overrun-rate"))
+            o.replay_gen.overrun_rate = parse_ratio(a.get<std::string>("--overrun-rate"));
+
+        o.stack.stack_size = a.get("--stack-size", o.stack.stack_size);
+        if (a.is_present("--spawn")) o.stack.spawn = a.get_all<int>("--spawn");
+        if (a.is_present("--trials")) o.stack.trials = o.trials;
+    } catch (const std::invalid_argument& e) {
+        std::cerr << "[error] " << e.what() << " (see --help)\n";
+        std::exit(2);
     }
-    if (a.is_present("--trials"))  o.trials = std::stoi(a.get_options("--trials")[0]);
-    if (a.is_present("--alloc"))   o.alloc  = std::stoull(a.get_options("--alloc")[0]);
-    if (a.is_present("--overrun")) o.over   = std::stoull(a.get_options("--overrun")[0]);
-    if (a.is_present("--addr"))    o.addr   = std::stoull(a.get_options("--addr")[0], nullptr, 16);
+
+    o.daemon.socket_path = o.daemon_socket;
+    o.daemon.alloc       = o.allocs.front();
+    o.daemon.addr        = o.addr;
+    o.daemon.kernel      = o.test != Opt::Which::Heap;
+    if (a.is_present("--overrun")) o.daemon.overrun = o.over;
     return o;
 }
 
+// A guarded run plus what the heap test can tell about where it faulted
+struct Trial : RunResult {
+    long long fault_offset   = -1;  // si_addr minus region base (heap only)
+    long long prefault_bytes = -1;  // bytes written past the allocation before the fault
+    long long fill_ns        = 0;   // time spent writing them
+    long long trap_ns        = 0;   // trapping store → back in the guard
+    long long alloc_ops      = -1;  // malloc/free calls until glibc noticed (malloc test)
+    std::string check;              // which glibc check fired (malloc test)
+};
+
+// One test case and everything collected for it while it runs
+struct TestRun {
+    std::string            name;
+    std::function<void()>  fn;
+    std::function<void()>  cleanup;  // runs after the guard, e.g. after a fault
+    std::size_t            alloc = 0;  // heap allocation size, 0 = not a heap test
+    Load                   load  = Load::Idle;  // co-runner profile active while it runs
+    bool                   corrupt = false;     // malloc-corruption test: result comes from its profile
+    std::vector<Trial>     res{};
+    int         attempts = 0;
+    int         dropped  = 0;
+    bool        done     = false;
+    double      rel_ci   = 0.0;     // last relative CI half-width seen
+    std::string stop{};             // why sampling stopped
+};
+
+// One line per fault the handlers recorded, in the order they were drained
+static bool write_fault_log(const std::string& path, const std::vector<FaultRecord>& faults)
+{
+    std::ofstream f(path);
+    f << "Ns,Tid,Cpu,Signal,Code,Addr\n";
+    for (const auto& r : faults)
+        f << r.ns << ',' << r.tid << ',' << r.cpu << ',' << r.signo << ',' << r.code
+          << ",0x" << std::hex << r.addr << std::dec << '\n';
+    return static_cast<bool>(f);
+}
+
 // Main function to run tests
 int main(int argc, char** argv)
 {
     Opt opt = parse(argc, argv);
 
+    if (opt.cpu >= 0 && !pin_to_cpu(opt.cpu))
+        std::cerr << "[warn] could not pin to CPU " << opt.cpu << '\n';
+
+    // Co-runners go on every other CPU; stay where we are so that they
+    // contend with the trials instead of preempting them
+    const bool loaded = std::any_of(opt.loads.begin(), opt.loads.end(), [](Load l) { return l != Load::Idle; });
+    if (loaded && opt.cpu < 0 && opt.load_cpus.empty()) {
+        const int here = take_interference_snapshot().cpu;
+        if (here >= 0 && pin_to_cpu(here)) opt.cpu = here;
+    }
+
+    // Handlers push into per-thread rings; drained here between batches
+    std::vector<FaultRecord> faults;
+    if (!opt.fault_log.empty()) {
+        fault_ring_enable();
+        fault_ring_attach();
+    }
+    auto finish = [&](int rc) {
+        if (opt.fault_log.empty()) return rc;
+        fault_ring_drain(faults);
+        if (write_fault_log(opt.fault_log, faults))
+            std::cout << "[faults] " << faults.size() << " recorded, " << fault_ring_dropped()
+                      << " dropped → " << opt.fault_log << '\n';
+        else
+            std::cerr << "[warn] could not write " << opt.fault_log << '\n';
+        return rc;
+    };
+
+    if (!opt.daemon_socket.empty())
+        return run_probe_daemon(opt.daemon);
+    if (opt.shootdown)
+        return finish(run_shootdown_bench(opt.shoot));
+    if (opt.stack_guard)
+        return finish(run_stack_guard_bench(opt.stack));
+    if (opt.redzone)
+        return finish(run_redzone_bench(opt.rz));
+    if (!opt.replay_gen.file.empty())
+        return generate_replay_trace(opt.replay_gen);
+    if (!opt.replay.file.empty())
+        return finish(run_replay(opt.replay));
+
+    if (!opt.trace_file.empty())
+        trace_enable();
+
+    const HostFingerprint host = collect_host_fingerprint();
+    std::cout << "[host] config " << host.config_hash() << '\n';
+
     std::ofstream csv("mem_crash_results.csv");
-    csv << "Trial,Test,Time_ns,SegFaulted\n";
-
-    std::vector<RunResult> heap_res, kern_res;
-    
-    std::cout << "Starting heap overflow test...\n";
-    auto heap_fn = [&] { run_heap_overflow(opt.alloc, opt.over); };
-    std::cout << "Heap overflow test finished.\n";
-    
+    write_fingerprint_header(csv, host);
+    csv << "Trial,Test,Time_ns,SegFaulted,VolCtxSw,InvolCtxSw,Migrated,IRQs,Disturbed,"
+           "Alloc,FaultOffset,PreFaultBytes,Fill_ns,Trap_ns,Load,AllocOps\n";
+
+    std::vector<TestRun> tests;
+
+
     std::cout << "Starting kernel access test...\n";
     auto kern_fn = [&] { run_kernel_access(opt.addr); };
     std::cout << "Kernel access test finished.\n";
 
-    for (int t = 1; t <= opt.trials; ++t) {
-        // Run heap test on all platforms (Linux/Windows)
-        {
-            auto r = run_with_guard(heap_fn);
-            heap_res.push_back(r);
-            csv << t << ",Heap," << r.ns << ',' << r.crashed << '\n';
+    // Every test once per load profile; the suffix keeps them apart in the CSV
+    for (Load load : opt.loads) {
+        const std::string suffix = opt.loads.size() > 1 || load != Load::Idle
+                                 ? std::string("@") + load_name(load) : std::string();
+
+        // Run heap test on all platforms (Linux/Windows), once per --alloc value
+        std::cout << "Starting heap overflow test...\n";
+        for (std::size_t alloc : opt.allocs) {
+            auto heap_fn = [&opt, alloc] { run_heap_overflow(alloc, opt.over); };
+            std::string name = opt.allocs.size() > 1 ? "Heap/" + std::to_string(alloc) : "Heap";
+            tests.push_back({ name + suffix, heap_fn, release_heap_overflow_region, alloc, load });
         }
+        std::cout << "Heap overflow test finished.\n";
 
+        // Same sizes through real malloc, without a guard page
+        if (opt.malloc_corrupt)
+            for (std::size_t alloc : opt.allocs) {
+                auto fn = [&opt, alloc] {
+                    run_malloc_corruption(alloc, opt.corrupt_bytes, opt.corrupt_target, opt.malloc_ops);
+                };
+                std::string name = opt.allocs.size() > 1 ? "Malloc/" + std::to_string(alloc) : "Malloc";
+                tests.push_back({ name + suffix, fn, nullptr, alloc, load, true });
+            }
 #if !defined(_WIN32)
         // Only run the kernel test on Linux/macOS, skip on Windows
-        if (opt.test == Opt::Which::Kernel || opt.test == Opt::Which::Both) {
-            auto r = run_with_guard(kern_fn);
-            kern_res.push_back(r);
-            csv << t << ",Kernel," << r.ns << ',' << r.crashed << '\n';
-        }
+        if (opt.test == Opt::Which::Kernel || opt.test == Opt::Which::Both)
+            tests.push_back({ "Kernel" + suffix, kern_fn, nullptr, 0, load });
 #else
         // Skip kernel test on Windows
         if (opt.test != Opt::Which::Heap) {
@@ -153,29 +416,223 @@ int main(int argc, char** argv)
         }
 #endif
     }
-    csv.close();
+    const std::vector<int> load_cpus = opt.load_cpus.empty() ? default_load_cpus(opt.cpu)
+                                                             : opt.load_cpus;
+
+    const bool adaptive   = opt.target_ci > 0.0;
+    const int  max_trials = adaptive ? opt.max_trials : opt.trials;
+    const int  batch      = adaptive ? opt.batch      : 1;
+    auto       deadline   = std::chrono::steady_clock::time_point{};
+
+    // Records one trial unless it was disturbed and the user asked to drop those
+    auto record = [&](TestRun& tr, const RunResult& r) {
+        // The malloc test's window is a fork + wait, which always switches
+        // context; its timing comes from the child, so it is never dropped
+        const bool disturbed = r.disturbed && !tr.corrupt;
+        if (opt.discard_disturbed && disturbed) { ++tr.dropped; return; }
+        // A malloc trial that never overran anything says nothing about detection
+        if (tr.corrupt && last_malloc_corruption_profile().failed) { ++tr.dropped; return; }
 
-    auto summarise = [&](const std::vector<RunResult>& v) {
-        long long total = 0; int faults = 0;
-        for (auto& x : v) { total += x.ns; faults += x.crashed; }
-        return std::pair<long long, int>{ v.empty() ? 0 : total / static_cast<long long>(v.size()), faults };
+        Trial x;
+        static_cast<RunResult&>(x) = r;
+        if (tr.corrupt) {
+            // Detection happened in the child; its clock is the same steady clock
+            const MallocCorruptProfile& p = last_malloc_corruption_profile();
+            x.disturbed = false;
+            x.crashed   = p.detected;
+            x.signal    = p.signal;
+            x.ns        = p.ns;
+            x.alloc_ops = p.ops;
+            x.check     = p.check;
+        } else if (tr.alloc) {
+            const HeapOverflowProfile& p = last_heap_overflow_profile();
+            x.fill_ns = p.fill_ns;
+            if (r.crashed && r.fault_addr >= p.base) {
+                x.fault_offset   = static_cast<long long>(r.fault_addr - p.base);
+                x.prefault_bytes = x.fault_offset - static_cast<long long>(p.alloc);
+                x.trap_ns        = r.end_ns - p.fill_end_ns;
+            }
+        }
+        tr.res.push_back(x);
+
+        csv << tr.attempts << ',' << tr.name << ',' << x.ns << ',' << x.crashed << ','
+            << r.noise.vol_csw << ',' << r.noise.invol_csw << ','
+            << r.noise.migrated << ',' << r.noise.irqs << ',' << x.disturbed << ','
+            << tr.alloc << ',' << x.fault_offset << ',' << x.prefault_bytes << ','
+            << x.fill_ns << ',' << x.trap_ns << ',' << load_name(tr.load) << ','
+            << x.alloc_ops << '\n';
     };
 
-    auto [h_avg, h_fault] = summarise(heap_res);
-    auto [k_avg, k_fault] = summarise(kern_res);
+    // Decides after each batch whether a test has converged
+    auto judge = [&](TestRun& tr) {
+        std::vector<long long> ns;
+        for (auto& x : tr.res) ns.push_back(x.ns);
+
+        if (adaptive && !ns.empty()) {
+            const double centre = opt.ci_median ? static_cast<double>(percentile(ns, 50)) : mean(ns);
+            const double half   = opt.ci_median ? median_ci_half_width(ns) : mean_ci_half_width(ns);
+            tr.rel_ci = centre > 0 ? half / centre : 0.0;
+            if (static_cast<int>(ns.size()) >= opt.min_trials && tr.rel_ci <= opt.target_ci) {
+                tr.done = true; tr.stop = "converged";
+                return;
+            }
+        }
+        if (tr.attempts >= max_trials) {
+            tr.done = true; tr.stop = adaptive ? "max-trials" : "fixed";
+        } else if (adaptive && std::chrono::steady_clock::now() >= deadline) {
+            tr.done = true; tr.stop = "budget";
+        }
+    };
+
+    // One load profile at a time, with its co-runners up for the whole
+    // pass.  Within a pass tests are interleaved batch by batch so drift
+    // affects them equally; each one drops out as soon as its own estimate
+    // is tight enough.
+    for (Load load : opt.loads) {
+        deadline = std::chrono::steady_clock::now()
+                 + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                       std::chrono::duration<double>(opt.budget_s));
+        CoRunner co(load, load_cpus);
+        for (bool active = true; active; ) {
+            active = false;
+            for (auto& tr : tests) {
+                if (tr.done || tr.load != load) continue;
+                for (int i = 0; i < batch && tr.attempts < max_trials; ++i) {
+                    ++tr.attempts;
+                    trace_begin_trial(tr.name.c_str(), static_cast<std::uint32_t>(tr.attempts));
+                    const RunResult r = run_with_guard(tr.fn);
+                    if (tr.cleanup) tr.cleanup();
+                    trace_end_trial();
+                    record(tr, r);
+                }
+                if (!opt.fault_log.empty()) fault_ring_drain(faults);
+                judge(tr);
+                active |= !tr.done;
+            }
+        }
+        const double rate = co.stop();
+        if (load != Load::Idle)
+            std::cout << "[load] " << load_name(load) << " on " << load_cpus.size()
+                      << " co-runner(s): " << std::setprecision(3) << rate << ' '
+                      << co.rate_unit() << std::defaultfloat << '\n';
+    }
+    csv.close();
+
+    if (!opt.trace_file.empty()) {
+        if (write_trace_json(opt.trace_file))
+            std::cout << "[trace] timeline written → " << opt.trace_file << '\n';
+        else
+            std::cerr << "[warn] could not write " << opt.trace_file << '\n';
+    }
+
+    struct Summary { long long avg, p50, p99; int faults, disturbed; };
+    auto summarise = [&](const std::vector<Trial>& v) {
+        long long total = 0; int faults = 0, disturbed = 0;
+        std::vector<long long> ns;
+        for (auto& x : v) {
+            total += x.ns; faults += x.crashed; disturbed += x.disturbed;
+            ns.push_back(x.ns);
+        }
+        return Summary{ v.empty() ? 0 : total / static_cast<long long>(v.size()),
+                        percentile(ns, 50), percentile(ns, 99), faults, disturbed };
+    };
 
     std::stringstream out;
-    out << "\n| Test   | Avg time (ns) | Trials | SIGSEGVs |\n"
-        << "|--------|--------------:|-------:|---------:|\n";
-    if (!heap_res.empty())
-        out << "| Heap   | " << std::setw(12) << h_avg << " | "
-            << heap_res.size() << " | " << h_fault << " |\n";
-#if !defined(_WIN32)
-    if (!kern_res.empty())
-        out << "| Kernel | " << std::setw(12) << k_avg << " | "
-            << kern_res.size() << " | " << k_fault << " |\n";
-#endif
+    out << "\n| Test   | Avg time (ns) |   p50 (ns) |   p99 (ns) | Trials | SIGSEGVs | Disturbed | Dropped |\n"
+        <<   "|--------|--------------:|-----------:|-----------:|-------:|---------:|----------:|--------:|\n";
+    for (auto& tr : tests) {
+        if (tr.res.empty()) continue;
+        const Summary s = summarise(tr.res);
+        out << "| " << std::left << std::setw(6) << tr.name << std::right << " | "
+            << std::setw(12) << s.avg << " | "
+            << std::setw(10) << s.p50 << " | " << std::setw(10) << s.p99 << " | "
+            << tr.res.size() << " | " << s.faults << " | " << s.disturbed << " | "
+            << tr.dropped << " |\n";
+    }
+
+    // Pre-fault fill vs. trap: per allocation size, then a line through all
+    // of them.  Bytes written before the fault shrink as --alloc approaches
+    // the page size.  Only overrun start → recovery is fitted (mmap,
+    // mprotect and the allocation's own memset stay out), so the slope is
+    // the fill cost and the intercept the trap cost.
+    std::vector<double> fit_x, fit_y;
+    bool fault_rows = false;
+    for (auto& tr : tests) {
+        std::vector<long long> gbps_x1000, trap;
+        long long bytes = -1;
+        for (auto& x : tr.res) {
+            if (x.prefault_bytes < 0) continue;
+            bytes = x.prefault_bytes;
+            if (x.fill_ns > 0) gbps_x1000.push_back(x.prefault_bytes * 1000 / x.fill_ns);
+            trap.push_back(x.trap_ns);
+            fit_x.push_back(static_cast<double>(x.prefault_bytes));
+            fit_y.push_back(static_cast<double>(x.fill_ns + x.trap_ns));
+        }
+        if (bytes < 0) continue;
+        if (!fault_rows) {
+            out << "\n| Test   | Pre-fault bytes | Fill GB/s (p50) | Trap ns (p50) |\n"
+                <<   "|--------|----------------:|----------------:|--------------:|\n";
+            fault_rows = true;
+        }
+        out << "| " << std::left << std::setw(6) << tr.name << std::right << " | "
+            << std::setw(15) << bytes << " | " << std::fixed << std::setprecision(2)
+            << std::setw(15) << percentile(gbps_x1000, 50) / 1000.0 << " | "
+            << std::setw(13) << percentile(trap, 50) << " |\n";
+    }
+    if (fault_rows) {
+        const LinearFit f = fit_linear(fit_x, fit_y);
+        if (f.slope > 0)
+            out << "\nFill_ns + Trap_ns ≈ " << std::setprecision(0) << f.intercept << " + "
+                << std::setprecision(4) << f.slope << " · bytes   (R² = "
+                << std::setprecision(3) << f.r2 << ", n = " << f.n << ")\n"
+                << "  trap ≈ " << std::setprecision(0) << f.intercept << " ns, "
+                << "fill ≈ " << std::setprecision(2) << 1.0 / f.slope << " GB/s\n";
+        else
+            out << "\n(sweep --alloc over several sizes to separate fill from trap cost)\n";
+        out << std::defaultfloat;
+    }
+
+    // Guard page vs. glibc's own checks: how long corruption stays silent
+    bool malloc_rows = false;
+    for (auto& tr : tests) {
+        if (!tr.corrupt || tr.res.empty()) continue;
+        std::vector<long long> ops, ns;
+        std::map<std::string, int> checks;
+        for (auto& x : tr.res) {
+            ++checks[x.check];
+            if (!x.crashed) continue;
+            ops.push_back(x.alloc_ops);
+            ns.push_back(x.ns);
+        }
+        const auto top = std::max_element(checks.begin(), checks.end(),
+                                          [](auto& l, auto& r) { return l.second < r.second; });
+        if (!malloc_rows) {
+            out << "\nglibc detection of a " << opt.corrupt_bytes << "-byte overrun into the next chunk ("
+                << (opt.corrupt_target == CorruptTarget::Size ? "live, size field" : "freed, size + tcache next")
+                << "), no guard page\n"
+                << "\n| Test   | Detected | Ops to abort (p50) | Time to abort (p50 ns) | Most frequent outcome |\n"
+                <<   "|--------|---------:|-------------------:|-----------------------:|-----------------------|\n";
+            malloc_rows = true;
+        }
+        out << "| " << std::left << std::setw(6) << tr.name << std::right << " | "
+            << std::setw(4) << ns.size() << '/' << std::left << std::setw(3) << tr.res.size() << std::right
+            << " | " << std::setw(18) << (ops.empty() ? -1 : percentile(ops, 50)) << " | "
+            << std::setw(22) << (ns.empty() ? -1 : percentile(ns, 50)) << " | "
+            << top->first << " |\n";
+    }
+
+    if (adaptive) {
+        out << "\n95 % CI of the " << (opt.ci_median ? "median" : "mean") << ", relative half-width\n"
+            << "\n| Test   | Attempts |   ± CI | Target | Stop       |\n"
+            <<   "|--------|---------:|-------:|-------:|------------|\n";
+        for (auto& tr : tests)
+            out << "| " << std::left << std::setw(6) << tr.name << std::right << " | "
+                << std::setw(8) << tr.attempts << " | " << std::fixed << std::setprecision(2)
+                << std::setw(5) << tr.rel_ci * 100 << "% | "
+                << std::setw(5) << opt.target_ci * 100 << "% | "
+                << std::left << std::setw(10) << tr.stop << std::right << " |\n";
+    }
 
     zen::print(out.str());
-    return 0;
+    return finish(0);
 }
@@ -0,0 +1,195 @@
+#include "malloc_corrupt.h"
+#include "crash_guard.h"
+
+static MallocCorruptProfile PROFILE;
+
+const MallocCorruptProfile& last_malloc_corruption_profile() { return PROFILE; }
+
+const char* corrupt_target_name(CorruptTarget t)
+{
+    switch (t) {
+        case CorruptTarget::Size:   return "size";
+        case CorruptTarget::Tcache: return "tcache";
+    }
+    return "?";
+}
+
+bool parse_corrupt_target(const std::string& s, CorruptTarget& out)
+{
+    for (CorruptTarget t : { CorruptTarget::Size, CorruptTarget::Tcache })
+        if (s == corrupt_target_name(t)) { out = t; return true; }
+    return false;
+}
+
+#if !defined(__GLIBC__)
+
+void run_malloc_corruption(std::size_t, std::size_t, CorruptTarget, long long)
+{
+    PROFILE = MallocCorruptProfile{};
+    PROFILE.check = "unsupported (needs glibc)";
+}
+
+#else
+
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include <malloc.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+// Lives in a MAP_SHARED page so the parent can read it after the child died
+struct Shared {
+    volatile long long overrun_ns;
+    volatile long long detect_ns;
+    volatile long long ops;
+    volatile int       signal;
+    volatile int       no_pair;       // never found B right after A: nothing was overrun
+};
+
+Shared* SHARED = nullptr;
+
+void on_detect(int sig)
+{
+    SHARED->detect_ns = guard_clock_ns();
+    SHARED->signal    = sig;
+    _exit(128 + sig);
+}
+
+// Everything below runs in the child; it never returns
+[[noreturn]] void child(std::size_t alloc, std::size_t overrun, CorruptTarget target, long long max_ops)
+{
+    struct sigaction sa{};
+    sa.sa_handler = on_detect;
+    sigemptyset(&sa.sa_mask);
+    for (int s : { SIGABRT, SIGSEGV, SIGBUS }) sigaction(s, &sa, nullptr);
+
+    // A, its victim neighbour B, and C so B never merges with top.  Chunks
+    // the parent freed earlier are handed out first and need not be
+    // adjacent, so keep allocating until B follows A; the misses are freed
+    // once C holds the top chunk off.
+    constexpr int TRIES = 4096;
+    static char* probes[2 * TRIES];
+    int   nprobes = 0;
+    char* a       = nullptr;
+    char* b       = nullptr;
+    for (int tries = 0; tries < TRIES; ++tries) {
+        a = static_cast<char*>(std::malloc(alloc));
+        b = static_cast<char*>(std::malloc(alloc));
+        if (a && b && b == a + malloc_usable_size(a) + sizeof(std::size_t)) break;
+        probes[nprobes++] = a;
+        probes[nprobes++] = b;
+        a = b = nullptr;
+    }
+    if (!a) {
+        SHARED->no_pair = 1;
+        _exit(0);
+    }
+    auto* c = static_cast<char*>(std::malloc(alloc));
+    for (int i = 0; i < nprobes; ++i) std::free(probes[i]);
+    if (target == CorruptTarget::Tcache) { std::free(b); b = nullptr; }
+
+    // The overrun starts at the usable end of A (glibc rounds requests up
+    // and lends A the next chunk's prev_size), so byte 1 is metadata.
+    // Byte-wise through a volatile pointer so the compiler cannot reason
+    // about (or fortify) the out-of-bounds stores.
+    const std::size_t usable = malloc_usable_size(a);
+    volatile char* p = a;
+    SHARED->overrun_ns = guard_clock_ns();
+    for (std::size_t i = 0; i < overrun; ++i) p[usable + i] = 'A';
+
+    // Pointer slots without hidden allocations; B and C start out live
+    constexpr int SLOTS = 64;
+    static const std::size_t SIZES[] = { 24, 40, 56, 120, 250, 500, 1000, 4000 };
+    char* slots[SLOTS] = { b, c };
+    std::uint64_t x = 0x9E3779B97F4A7C15ULL;
+    for (long long op = 0; op < max_ops; ++op) {
+        x ^= x << 13; x ^= x >> 7; x ^= x << 17;             // xorshift64
+        // Freeing B (or reallocating its size class) first is what a real
+        // program does next; after that the mix is random, biased to `alloc`
+        const int i = op < 2 ? static_cast<int>(op) : static_cast<int>(x % SLOTS);
+        if (slots[i]) {
+            std::free(slots[i]);
+            slots[i] = nullptr;
+        } else {
+            const std::size_t sz = op < 2 || (x >> 32) & 1 ? alloc : SIZES[(x >> 40) % 8];
+            slots[i] = static_cast<char*>(std::malloc(sz));
+            if (slots[i]) std::memset(slots[i], 0, sz < 64 ? sz : 64);
+        }
+        SHARED->ops = op + 1;
+    }
+    SHARED->detect_ns = guard_clock_ns();
+    _exit(0);
+}
+
+// First line of what glibc printed
+std::string first_line(const std::string& s)
+{
+    std::string line = s.substr(0, s.find('\n'));
+    while (!line.empty() && (line.back() == '\r' || line.back() == ' ')) line.pop_back();
+    return line;
+}
+
+} // namespace
+
+void run_malloc_corruption(std::size_t alloc_sz, std::size_t overrun_sz,
+                           CorruptTarget target, long long max_ops)
+{
+    PROFILE = MallocCorruptProfile{};
+    if (!SHARED) {
+        void* m = mmap(nullptr, sizeof(Shared), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (m == MAP_FAILED) { PROFILE.failed = true; PROFILE.check = "mmap failed"; return; }
+        SHARED = static_cast<Shared*>(m);
+    }
+    SHARED->overrun_ns = SHARED->detect_ns = SHARED->ops = 0;
+    SHARED->signal     = 0;
+    SHARED->no_pair    = 0;
+
+    int err[2];
+    if (pipe(err) != 0) { PROFILE.failed = true; PROFILE.check = "pipe failed"; return; }
+
+    const pid_t pid = fork();
+    if (pid < 0) {
+        close(err[0]); close(err[1]);
+        PROFILE.failed = true;
+        PROFILE.check  = "fork failed";
+        return;
+    }
+    if (pid == 0) {
+        close(err[0]);
+        dup2(err[1], STDERR_FILENO);       // glibc reports the failed check here
+        close(err[1]);
+        child(alloc_sz, overrun_sz, target, max_ops);
+    }
+
+    close(err[1]);
+    std::string msg;
+    char buf[512];
+    for (ssize_t n; (n = read(err[0], buf, sizeof buf)) != 0;) {
+        if (n < 0) { if (errno == EINTR) continue; break; }
+        msg.append(buf, static_cast<std::size_t>(n));
+    }
+    close(err[0]);
+
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {}
+
+    PROFILE.failed   = SHARED->no_pair != 0;
+    PROFILE.ops      = SHARED->ops;
+    PROFILE.signal   = SHARED->signal;
+    PROFILE.detected = PROFILE.signal != 0;
+    PROFILE.ns       = SHARED->detect_ns > 0 ? SHARED->detect_ns - SHARED->overrun_ns : 0;
+    if (PROFILE.failed)                 PROFILE.check = "no adjacent chunks";
+    else if (PROFILE.signal == SIGABRT) PROFILE.check = first_line(msg);
+    else if (PROFILE.detected)          PROFILE.check = PROFILE.signal == SIGSEGV ? "SIGSEGV" : "SIGBUS";
+    else if (WIFEXITED(status))         PROFILE.check = "undetected";
+    else                                PROFILE.check = "child died";
+}
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef MALLOC_CORRUPT_H
+#define MALLOC_CORRUPT_H
+
+#include <cstddef>
+#include <string>
+
+/** What the overrun of a real `malloc` chunk clobbers. */
+enum class CorruptTarget {
+    Size,       // size field of the next, still allocated chunk
+    Tcache,     // size + tcache `next` pointer of the next chunk, already freed
+};
+
+const char* corrupt_target_name(CorruptTarget t);
+
+/** Parses "size" or "tcache"; false if unknown. */
+bool parse_corrupt_target(const std::string& s, CorruptTarget& out);
+
+/**
+ * Outcome of the last `run_malloc_corruption`.  Without a guard page the
+ * overrun itself is silent; glibc only notices when a later malloc/free
+ * runs one of its integrity checks and aborts — or never.
+ */
+struct MallocCorruptProfile {
+    bool        failed   = false;   // nothing was overrun (no adjacent chunk pair, fork failed, ...)
+    bool        detected = false;   // the allocator aborted (or the heap faulted)
+    int         signal   = 0;       // SIGABRT, or SIGSEGV/SIGBUS on a wild pointer
+    long long   ns       = 0;       // overrun → detection (or → giving up)
+    long long   ops      = 0;       // malloc/free calls completed after the overrun
+    std::string check;              // glibc's diagnostic, e.g. "free(): invalid size"
+};
+
+/**
+ * Overruns a `malloc(alloc_sz)` chunk by `overrun_sz` bytes into its
+ * neighbour's header, then runs up to `max_ops` pseudo-random
+ * malloc/free calls until glibc aborts.  Runs in a forked child so the
+ * corrupted heap never touches this process.
+ */
+void run_malloc_corruption(std::size_t alloc_sz, std::size_t overrun_sz,
+                           CorruptTarget target, long long max_ops);
+
+const MallocCorruptProfile& last_malloc_corruption_profile();
+#endif // MALLOC_CORRUPT_H
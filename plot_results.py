@@ -14,7 +14,7 @@ import pandas as pd
 import matplotlib.pyplot as plt
 
 fname = sys.argv[1] if len(sys.argv) > 1 else "mem_crash_results.csv"
-df = pd.read_csv(fname)
+df = pd.read_csv(fname, comment="#")   # skip the host-fingerprint header
 
 # Aggregate
 avg = df.groupby("Test")["Time_ns"].mean().reset_index()
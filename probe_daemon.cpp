@@ -0,0 +1,347 @@
+#include "probe_daemon.h"
+
+#if defined(_WIN32)
+
+#include <iostream>
+
+int run_probe_daemon(const DaemonConfig&)
+{
+    std::cerr << "[daemon] Unix-socket probe daemon is not available on Windows\n";
+    return 1;
+}
+
+#else
+
+#include "crash_guard.h"
+#include "heap_overflow.h"
+#include "host_info.h"
+#include "kernel_access.h"
+#include "latency_histogram.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string_view>
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+volatile std::sig_atomic_t STOP = 0;
+
+void on_stop(int) { STOP = 1; }
+
+// Latency histogram plus how many of its samples were disturbed
+struct Histogram : LatencyHistogram {
+    std::uint64_t disturbed = 0;
+
+    void add(std::uint64_t ns, bool was_disturbed)
+    {
+        LatencyHistogram::add(ns);
+        disturbed += was_disturbed;
+    }
+
+    void merge(const Histogram& h)
+    {
+        LatencyHistogram::merge(h);
+        disturbed += h.disturbed;
+    }
+};
+
+struct Probe {
+    const char*           name;
+    std::function<void()> fn;
+    std::function<void()> cleanup;
+    std::uint64_t         total = 0;     // probes since start
+    std::uint64_t         faults = 0;
+};
+
+// One slot of the time ring: a histogram per probe for one bucket period
+struct Bucket {
+    long long              epoch = -1;   // unix time / bucket_seconds
+    std::vector<Histogram> hist;
+};
+
+class Daemon {
+public:
+    explicit Daemon(const DaemonConfig& cfg) : cfg_(cfg), ring_(static_cast<std::size_t>(std::max(1, cfg.buckets)))
+    {
+        probes_.push_back({ "heap",
+                            [this] { run_heap_overflow(cfg_.alloc, cfg_.overrun, false); },
+                            release_heap_overflow_region });
+        if (cfg_.kernel)
+            probes_.push_back({ "kernel", [this] { run_kernel_access(cfg_.addr, false); }, nullptr });
+        for (auto& b : ring_) b.hist.resize(probes_.size());
+        host_ = collect_host_fingerprint();
+    }
+
+    int run()
+    {
+        const int fd = listen_on(cfg_.socket_path);
+        if (fd < 0) return 1;
+
+        std::cout << "[daemon] probing at ≤" << cfg_.duty * 100 << " % duty, serving on "
+                  << cfg_.socket_path << '\n';
+
+        const double idle_factor = cfg_.duty > 0 ? (1.0 / cfg_.duty - 1.0) : 1e6;
+        auto next = Clock::now();
+        std::size_t which = 0;
+
+        while (!STOP) {
+            if (Clock::now() >= next) {
+                const auto t0 = Clock::now();
+                probe(probes_[which]);
+                which = (which + 1) % probes_.size();
+                const auto t1 = Clock::now();
+
+                // Sleep long enough that probing stays under the duty cycle
+                const auto busy = t1 - t0;
+                busy_ += busy;
+                next = t1 + std::max<Clock::duration>(
+                    std::chrono::milliseconds(1),
+                    std::chrono::duration_cast<Clock::duration>(busy * idle_factor));
+            }
+
+            const auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(next - Clock::now());
+            pollfd p{ fd, POLLIN, 0 };
+            if (poll(&p, 1, static_cast<int>(std::max<long long>(0, wait.count()))) > 0)
+                serve(fd);
+        }
+
+        close(fd);
+        unlink(cfg_.socket_path.c_str());
+        std::cout << "[daemon] stopped\n";
+        return 0;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    long long current_epoch() const
+    {
+        const auto now = std::chrono::system_clock::now().time_since_epoch();
+        return std::chrono::duration_cast<std::chrono::seconds>(now).count()
+             / std::max(1, cfg_.bucket_seconds);
+    }
+
+    Bucket& bucket_for(long long epoch)
+    {
+        Bucket& b = ring_[static_cast<std::size_t>(epoch) % ring_.size()];
+        if (b.epoch != epoch) {
+            b.epoch = epoch;
+            std::fill(b.hist.begin(), b.hist.end(), Histogram{});
+        }
+        return b;
+    }
+
+    void probe(Probe& pr)
+    {
+        const RunResult r = run_with_guard(pr.fn);
+        if (pr.cleanup) pr.cleanup();
+        ++pr.total;
+        pr.faults += r.crashed;
+
+        const auto idx = static_cast<std::size_t>(&pr - probes_.data());
+        if (r.crashed)   // only completed faults say anything about the fault path
+            bucket_for(current_epoch()).hist[idx].add(static_cast<std::uint64_t>(r.ns), r.disturbed);
+    }
+
+    // Buckets still inside the window, oldest first
+    std::vector<const Bucket*> live_buckets() const
+    {
+        const long long now = current_epoch();
+        std::vector<const Bucket*> v;
+        for (auto& b : ring_)
+            if (b.epoch >= 0 && now - b.epoch < static_cast<long long>(ring_.size()))
+                v.push_back(&b);
+        std::sort(v.begin(), v.end(), [](auto* a, auto* b) { return a->epoch < b->epoch; });
+        return v;
+    }
+
+    Histogram window(std::size_t idx) const
+    {
+        Histogram h;
+        for (auto* b : live_buckets()) h.merge(b->hist[idx]);
+        return h;
+    }
+
+    double duty_ratio() const
+    {
+        const double up = std::chrono::duration<double>(Clock::now() - started_).count();
+        return up > 0 ? std::chrono::duration<double>(busy_).count() / up : 0.0;
+    }
+
+    std::string prometheus() const
+    {
+        std::ostringstream os;
+        const int window_s = cfg_.bucket_seconds * static_cast<int>(ring_.size());
+        os << "# HELP mem_crash_fault_latency_ns Time from trial start to recovered fault, "
+           << window_s << " s window.\n"
+           << "# TYPE mem_crash_fault_latency_ns summary\n";
+        for (std::size_t i = 0; i < probes_.size(); ++i) {
+            const Histogram h = window(i);
+            for (double q : { 0.5, 0.9, 0.99, 0.999 })
+                os << "mem_crash_fault_latency_ns{test=\"" << probes_[i].name << "\",quantile=\""
+                   << q << "\"} " << h.quantile(q) << '\n';
+            os << "mem_crash_fault_latency_ns_sum{test=\""   << probes_[i].name << "\"} " << h.sum()   << '\n'
+               << "mem_crash_fault_latency_ns_count{test=\"" << probes_[i].name << "\"} " << h.count() << '\n';
+        }
+        os << "# HELP mem_crash_fault_latency_max_ns Slowest fault in the window.\n"
+           << "# TYPE mem_crash_fault_latency_max_ns gauge\n";
+        for (std::size_t i = 0; i < probes_.size(); ++i)
+            os << "mem_crash_fault_latency_max_ns{test=\"" << probes_[i].name << "\"} " << window(i).max() << '\n';
+        os << "# HELP mem_crash_disturbed_probes Faults in the window that saw a context switch, migration or IRQ.\n"
+           << "# TYPE mem_crash_disturbed_probes gauge\n";
+        for (std::size_t i = 0; i < probes_.size(); ++i)
+            os << "mem_crash_disturbed_probes{test=\"" << probes_[i].name << "\"} " << window(i).disturbed << '\n';
+        os << "# HELP mem_crash_probes_total Probes run since start.\n"
+           << "# TYPE mem_crash_probes_total counter\n";
+        for (auto& p : probes_)
+            os << "mem_crash_probes_total{test=\"" << p.name << "\"} " << p.total << '\n';
+        os << "# HELP mem_crash_faults_total Probes that ended in a caught fault.\n"
+           << "# TYPE mem_crash_faults_total counter\n";
+        for (auto& p : probes_)
+            os << "mem_crash_faults_total{test=\"" << p.name << "\"} " << p.faults << '\n';
+        os << "# HELP mem_crash_probe_duty_ratio Share of wall time spent probing.\n"
+           << "# TYPE mem_crash_probe_duty_ratio gauge\n"
+           << "mem_crash_probe_duty_ratio " << duty_ratio() << '\n'
+           << "# HELP mem_crash_host_info Host fingerprint of this node.\n"
+           << "# TYPE mem_crash_host_info gauge\n"
+           << "mem_crash_host_info{config_hash=\"" << host_.config_hash() << "\"";
+        for (const auto& [k, v] : host_.fields)
+            if (k == "os.release" || k == "cpu.microcode" || k == "vuln.meltdown")
+                os << ',' << (k == "os.release" ? "release" : k == "cpu.microcode" ? "microcode" : "pti")
+                   << "=\"" << escape(v) << '"';
+        os << "} 1\n";
+        return os.str();
+    }
+
+    std::string json() const
+    {
+        auto stats = [](std::ostream& os, const Histogram& h) {
+            os << "{\"count\":" << h.count() << ",\"p50\":" << h.quantile(0.5)
+               << ",\"p90\":" << h.quantile(0.9) << ",\"p99\":" << h.quantile(0.99)
+               << ",\"max\":" << h.max() << ",\"disturbed\":" << h.disturbed << '}';
+        };
+
+        std::ostringstream os;
+        os << "{\"config_hash\":\"" << host_.config_hash() << "\",\"bucket_seconds\":" << cfg_.bucket_seconds
+           << ",\"duty_ratio\":" << duty_ratio() << ",\"window\":{";
+        for (std::size_t i = 0; i < probes_.size(); ++i) {
+            os << (i ? "," : "") << '"' << probes_[i].name << "\":";
+            stats(os, window(i));
+        }
+        os << "},\"buckets\":[";
+        bool first = true;
+        for (auto* b : live_buckets()) {
+            os << (first ? "" : ",") << "{\"start\":" << b->epoch * cfg_.bucket_seconds;
+            for (std::size_t i = 0; i < probes_.size(); ++i) {
+                os << ",\"" << probes_[i].name << "\":";
+                stats(os, b->hist[i]);
+            }
+            os << '}';
+            first = false;
+        }
+        os << "]}\n";
+        return os.str();
+    }
+
+    static std::string escape(const std::string& s)
+    {
+        std::string out;
+        for (char c : s) {
+            if (c == '"' || c == '\\') out += '\\';
+            out += c;
+        }
+        return out;
+    }
+
+    static int listen_on(const std::string& path)
+    {
+        sockaddr_un addr{};
+        if (path.size() >= sizeof(addr.sun_path)) {
+            std::cerr << "[daemon] socket path too long: " << path << '\n';
+            return -1;
+        }
+        addr.sun_family = AF_UNIX;
+        std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+        const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) { perror("socket"); return -1; }
+        unlink(path.c_str());
+        if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(fd, 16) != 0) {
+            perror("bind/listen");
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    // One request per connection: read the command line, answer, close
+    void serve(int listen_fd) const
+    {
+        const int c = accept(listen_fd, nullptr, nullptr);
+        if (c < 0) return;
+
+        char req[512] = {};
+        std::size_t got = 0;
+        pollfd p{ c, POLLIN, 0 };
+        while (got < sizeof(req) - 1 && poll(&p, 1, 200) > 0) {
+            const ssize_t n = read(c, req + got, sizeof(req) - 1 - got);
+            if (n <= 0) break;
+            got += static_cast<std::size_t>(n);
+            if (std::memchr(req, '\n', got)) break;
+        }
+
+        const std::string_view r(req, got);
+        const bool http = r.rfind("GET ", 0) == 0;
+        const bool as_json = http ? r.rfind("GET /json", 0) == 0 : r.rfind("json", 0) == 0;
+
+        std::string body = as_json ? json() : prometheus();
+        if (http)
+            body = "HTTP/1.0 200 OK\r\nContent-Type: "
+                 + std::string(as_json ? "application/json" : "text/plain; version=0.0.4")
+                 + "\r\nContent-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+
+        for (std::size_t off = 0; off < body.size(); ) {
+            const ssize_t n = write(c, body.data() + off, body.size() - off);
+            if (n <= 0) break;
+            off += static_cast<std::size_t>(n);
+        }
+        close(c);
+    }
+
+    DaemonConfig        cfg_;
+    std::vector<Probe>  probes_;
+    std::vector<Bucket> ring_;
+    HostFingerprint     host_;
+    Clock::time_point   started_ = Clock::now();
+    Clock::duration     busy_{};
+};
+
+} // namespace
+
+int run_probe_daemon(const DaemonConfig& cfg)
+{
+    struct sigaction sa{};
+    sa.sa_handler = on_stop;           // no SA_RESTART: poll() must wake up
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT,  &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+    std::signal(SIGPIPE, SIG_IGN);     // clients may hang up mid-answer
+
+    Daemon d(cfg);
+    return d.run();
+}
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef PROBE_DAEMON_H
+#define PROBE_DAEMON_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * Long‑running probe mode: keeps faulting at a low duty cycle and serves
+ * rolling latency statistics over a Unix domain socket, so regressions
+ * after a kernel or microcode update show up on live hosts.
+ *
+ * Samples go into log‑linear histograms held in a ring of time buckets
+ * (`buckets` × `bucket_seconds` of history).  A client that connects and
+ * sends `metrics` (or `GET /metrics`) gets Prometheus text format; `json`
+ * (or `GET /json`) returns the same data plus per‑bucket history.
+ */
+struct DaemonConfig {
+    std::string   socket_path    = "/tmp/mem_crash.sock";
+    double        duty           = 0.001;   // max share of wall time spent probing
+    int           bucket_seconds = 10;
+    int           buckets        = 60;      // 10 minutes of history by default
+    std::size_t   alloc          = 16;
+    std::size_t   overrun        = 8192;    // must cross the guard page to fault
+    std::uint64_t addr           = 0xFFFF000000000000ULL;
+    bool          kernel         = true;    // also probe the kernel address
+};
+
+/** Runs until SIGINT/SIGTERM; returns the process exit code. */
+int run_probe_daemon(const DaemonConfig& cfg);
+#endif // PROBE_DAEMON_H
@@ -0,0 +1,303 @@
+#include "redzone.h"
+#include "crash_guard.h"
+#include "heap_overflow.h"
+#include "stats.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#  define REDZONE_X86 1
+#  include <immintrin.h>
+#endif
+
+#ifdef _WIN32
+#  include <windows.h>
+#else
+#  include <sys/mman.h>
+#  include <unistd.h>
+#endif
+#if defined(__GLIBC__)
+#  include <malloc.h>
+#endif
+
+namespace {
+
+constexpr unsigned char CANARY = 0xFD;     // "no man's land", as in the MSVC debug heap
+
+struct alignas(16) Header {
+    std::size_t n;       // user size
+    std::size_t idx;     // position in LIVE
+};
+
+using Check = bool (*)(const unsigned char*);
+
+bool intact_scalar(const unsigned char* p)
+{
+    for (std::size_t i = 0; i < REDZONE_BYTES; ++i)
+        if (p[i] != CANARY) return false;
+    return true;
+}
+
+#if REDZONE_X86
+bool intact_sse2(const unsigned char* p)
+{
+    const __m128i c  = _mm_set1_epi8(static_cast<char>(CANARY));
+    const __m128i lo = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), c);
+    const __m128i hi = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16)), c);
+    return _mm_movemask_epi8(_mm_and_si128(lo, hi)) == 0xFFFF;
+}
+
+#if defined(__GNUC__)
+__attribute__((target("avx2")))
+#endif
+bool intact_avx2(const unsigned char* p)
+{
+    const __m256i c  = _mm256_set1_epi8(static_cast<char>(CANARY));
+    const __m256i eq = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)), c);
+    return _mm256_movemask_epi8(eq) == -1;
+}
+#endif
+
+bool has_avx2()
+{
+#if REDZONE_X86 && defined(__GNUC__)
+    return __builtin_cpu_supports("avx2");
+#elif REDZONE_X86 && defined(__AVX2__)
+    return true;                           // MSVC: only when built with /arch:AVX2
+#else
+    return false;
+#endif
+}
+
+struct Kernel {
+    const char* name;
+    Check       fn;
+};
+
+// Best first; the benchmark also times the others
+std::vector<Kernel> kernels()
+{
+    std::vector<Kernel> k;
+#if REDZONE_X86
+    if (has_avx2()) k.push_back({ "avx2", intact_avx2 });
+    k.push_back({ "sse2", intact_sse2 });
+#endif
+    k.push_back({ "scalar", intact_scalar });
+    return k;
+}
+
+Kernel               ACTIVE = kernels().front();
+std::vector<Header*> LIVE;
+
+unsigned char* user_of(Header* h) { return reinterpret_cast<unsigned char*>(h + 1) + REDZONE_BYTES; }
+
+bool intact(Header* h)
+{
+    const unsigned char* u = user_of(h);
+    return ACTIVE.fn(u - REDZONE_BYTES) && ACTIVE.fn(u + h->n);
+}
+
+} // namespace
+
+void* redzone_alloc(std::size_t n)
+{
+    auto* h = static_cast<Header*>(std::malloc(sizeof(Header) + REDZONE_BYTES + n + REDZONE_BYTES));
+    if (!h) return nullptr;
+    h->n   = n;
+    h->idx = LIVE.size();
+    LIVE.push_back(h);
+    unsigned char* u = user_of(h);
+    std::memset(u - REDZONE_BYTES, CANARY, REDZONE_BYTES);
+    std::memset(u + n, CANARY, REDZONE_BYTES);
+    return u;
+}
+
+bool redzone_free(void* p)
+{
+    if (!p) return true;
+    auto* h = reinterpret_cast<Header*>(static_cast<unsigned char*>(p) - REDZONE_BYTES) - 1;
+    const bool ok = intact(h);
+    LIVE[h->idx] = LIVE.back();            // swap-remove from the registry
+    LIVE[h->idx]->idx = h->idx;
+    LIVE.pop_back();
+    std::free(h);
+    return ok;
+}
+
+std::size_t redzone_sweep()
+{
+    std::size_t bad = 0;
+    for (Header* h : LIVE) bad += !intact(h);
+    return bad;
+}
+
+const char* redzone_simd() { return ACTIVE.name; }
+
+// ------------------------------------------------------------ benchmark
+
+namespace {
+
+std::size_t page_size()
+{
+#ifdef _WIN32
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    return static_cast<std::size_t>(si.dwPageSize);
+#else
+    return static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+// What heap_overflow.cpp does per allocation: map, arm the guard, unmap
+void* guarded_alloc(std::size_t rounded, std::size_t page)
+{
+#ifdef _WIN32
+    void* p = VirtualAlloc(nullptr, rounded + page, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    DWORD old;
+    if (p) VirtualProtect(static_cast<char*>(p) + rounded, page, PAGE_NOACCESS, &old);
+    return p;
+#else
+    void* p = mmap(nullptr, rounded + page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) return nullptr;
+    mprotect(static_cast<char*>(p) + rounded, page, PROT_NONE);
+    return p;
+#endif
+}
+
+void guarded_free(void* p, std::size_t len)
+{
+#ifdef _WIN32
+    (void)len;
+    VirtualFree(p, 0, MEM_RELEASE);
+#else
+    munmap(p, len);
+#endif
+}
+
+// Bytes the allocator really sets aside for a malloc(n)
+std::size_t malloc_footprint(std::size_t n)
+{
+#if defined(__GLIBC__)
+    void* p = std::malloc(n);
+    const std::size_t used = malloc_usable_size(p) + sizeof(std::size_t);   // + chunk header
+    std::free(p);
+    return used;
+#else
+    return (n + sizeof(std::size_t) + 15) / 16 * 16;
+#endif
+}
+
+template <class F>
+double ns_per_op(int iters, F&& f)
+{
+    const long long t0 = guard_clock_ns();
+    for (int i = 0; i < iters; ++i) f();
+    return static_cast<double>(guard_clock_ns() - t0) / iters;
+}
+
+} // namespace
+
+int run_redzone_bench(const RedZoneConfig& cfg)
+{
+    const std::size_t page  = page_size();
+    const int         iters = cfg.iters > 0 ? cfg.iters : 1;
+    const Kernel      best  = ACTIVE;
+
+    std::stringstream cost, detect;
+    cost << "\nAlloc + touch + free, ns per allocation, and bytes set aside\n"
+         << "\n| Alloc | malloc ns | red-zone ns | guard-page ns | malloc B | red-zone B | guard-page B |\n"
+         <<   "|------:|----------:|------------:|--------------:|---------:|-----------:|-------------:|\n";
+    detect << "\nDetection: red zones on free / in sweeps (" << cfg.live << " live blocks), "
+           << "guard page on the faulting store\n"
+           << "\n| Alloc | Verify on free ns |";
+    const std::vector<Kernel> ks = kernels();
+    std::vector<std::string> sweep_cols;
+    for (auto& k : ks) sweep_cols.push_back(std::string("Sweep ") + k.name + " ns/block");
+    for (auto& c : sweep_cols) detect << ' ' << c << " |";
+    detect << " Guard slack B | Guard trap p50 ns |\n|------:|------------------:|";
+    for (auto& c : sweep_cols) detect << std::string(c.size() + 1, '-') << ":|";
+    detect << "--------------:|------------------:|\n";
+
+    for (std::size_t n : cfg.sizes) {
+        const std::size_t rounded = (n + page - 1) / page * page;
+        volatile unsigned char sink = 0;
+        void* volatile         keep = nullptr;   // stops malloc/free pairs being elided
+
+        const double t_malloc = ns_per_op(iters, [&] {
+            auto* p = static_cast<unsigned char*>(std::malloc(n));
+            p[0] = 1; sink = p[0]; keep = p;
+            std::free(keep);
+        });
+        const double t_rz = ns_per_op(iters, [&] {
+            auto* p = static_cast<unsigned char*>(redzone_alloc(n));
+            p[0] = 1; sink = p[0];
+            redzone_free(p);
+        });
+        const double t_guard = ns_per_op(iters, [&] {
+            auto* p = static_cast<unsigned char*>(guarded_alloc(rounded, page));
+            p[0] = 1; sink = p[0];
+            guarded_free(p, rounded + page);
+        });
+        (void)sink; (void)keep;
+
+        const std::size_t fp_malloc = malloc_footprint(n);
+        const std::size_t fp_rz     = malloc_footprint(sizeof(Header) + 2 * REDZONE_BYTES + n);
+
+        cost << "| " << std::setw(5) << n << " | " << std::fixed << std::setprecision(1)
+             << std::setw(9) << t_malloc << " | " << std::setw(11) << t_rz << " | "
+             << std::setw(13) << t_guard << " | " << std::setw(8) << fp_malloc << " | "
+             << std::setw(10) << fp_rz << " | " << std::setw(12) << rounded + page << " |\n"
+             << std::defaultfloat;
+
+        // Sweep cost per kernel, plus a planted 1-byte overrun it must find
+        std::vector<void*> blocks(static_cast<std::size_t>(cfg.live > 0 ? cfg.live : 1));
+        for (auto& b : blocks) b = redzone_alloc(n);
+        static_cast<unsigned char*>(blocks.back())[n] = 0;
+        std::vector<double> sweep_ns;
+        std::size_t found = 0;
+        for (auto& k : ks) {
+            ACTIVE = k;
+            const int passes = 20;
+            const long long t0 = guard_clock_ns();
+            for (int i = 0; i < passes; ++i) found = redzone_sweep();
+            sweep_ns.push_back(static_cast<double>(guard_clock_ns() - t0) / passes / blocks.size());
+        }
+        ACTIVE = best;
+        const double t_verify = ns_per_op(iters, [&] { sink = intact(LIVE.front()); });
+        std::size_t caught_on_free = 0;
+        for (auto* b : blocks) caught_on_free += !redzone_free(b);
+        if (found != 1 || caught_on_free != 1)
+            std::cerr << "[redzone] planted overrun not detected (sweep " << found
+                      << ", free " << caught_on_free << ")\n";
+
+        // Guard page: the overrun has to cross the slack before it traps.
+        // Only the trapping store → recovery is timed, like the red-zone
+        // checks; mapping, arming and the slack fill are left out.
+        std::vector<long long> trap;
+        for (int t = 0; t < cfg.trials; ++t) {
+            const RunResult r = run_with_guard([&] { run_heap_overflow(n, rounded - n + 1, false); });
+            const long long fill_end = last_heap_overflow_profile().fill_end_ns;
+            release_heap_overflow_region();
+            if (r.crashed && fill_end > 0) trap.push_back(r.end_ns - fill_end);
+        }
+
+        detect << "| " << std::setw(5) << n << " | " << std::fixed << std::setprecision(1)
+               << std::setw(17) << t_verify << " | " << std::setprecision(2);
+        for (std::size_t i = 0; i < ks.size(); ++i)
+            detect << std::setw(static_cast<int>(sweep_cols[i].size())) << sweep_ns[i] << " | ";
+        detect << std::setw(13) << rounded - n << " | "
+               << std::setw(17) << percentile(trap, 50) << " |\n" << std::defaultfloat;
+    }
+
+    std::cout << "[redzone] " << REDZONE_BYTES << "-byte red zones, checks use " << redzone_simd() << '\n'
+              << cost.str() << detect.str()
+              << "\nOverruns longer than " << REDZONE_BYTES << " bytes jump the red zone and "
+              << "are only caught if they land in another block's canary\n";
+    return 0;
+}
@@ -0,0 +1,482 @@
+#include "replay.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+const char* replay_guard_name(ReplayGuard g)
+{
+    switch (g) {
+        case ReplayGuard::Page:    return "page";
+        case ReplayGuard::PageEnd: return "page-end";
+        case ReplayGuard::None:    return "none";
+    }
+    return "?";
+}
+
+bool parse_replay_guard(const std::string& s, ReplayGuard& out)
+{
+    for (ReplayGuard g : { ReplayGuard::Page, ReplayGuard::PageEnd, ReplayGuard::None })
+        if (s == replay_guard_name(g)) { out = g; return true; }
+    return false;
+}
+
+// ------------------------------------------------------------ generator
+
+namespace {
+
+struct Rng {
+    std::uint64_t x;
+    std::uint64_t next() { x ^= x << 13; x ^= x >> 7; x ^= x << 17; return x; }   // xorshift64
+};
+
+// Mostly small objects, some buffers, a few large ones
+std::uint32_t service_size(Rng& r)
+{
+    const std::uint64_t u = r.next();
+    switch (u % 20) {
+        case 19:                  return static_cast<std::uint32_t>(4096 + (u >> 8) % 61440);
+        case 14: case 15: case 16:
+        case 17: case 18:         return static_cast<std::uint32_t>(256 + (u >> 8) % 3840);
+        default:                  return static_cast<std::uint32_t>(8 + (u >> 8) % 248);
+    }
+}
+
+struct Live {
+    std::uint32_t slot;
+    std::uint32_t size;
+};
+
+} // namespace
+
+int generate_replay_trace(const ReplayGenConfig& cfg)
+{
+    const int       shards = std::max(cfg.shards, 1);
+    const long long total  = std::max(cfg.events, 0LL);
+    const auto      rate   = static_cast<std::uint64_t>(std::clamp(cfg.overrun_rate, 0.0, 1.0) * 1e6);
+
+    std::vector<ReplayEvent>   events;
+    std::vector<std::uint64_t> begin = { 0 };
+    events.reserve(static_cast<std::size_t>(total));
+    std::uint32_t slots = 0;
+
+    for (int s = 0; s < shards; ++s) {
+        const long long n    = total / shards + (s < total % shards ? 1 : 0);
+        const std::size_t end = events.size() + static_cast<std::size_t>(n);
+        Rng r{ 0x9E3779B97F4A7C15ULL * static_cast<std::uint64_t>(s + 1) };
+        std::vector<Live>          live;
+        std::vector<std::uint32_t> free_slots;
+        std::uint32_t              next_slot = 0;
+
+        auto emit = [&](std::uint32_t slot, ReplayOp op, std::uint32_t a, std::uint32_t b) {
+            if (events.size() < end) events.push_back({ slot, op, {}, a, b });
+        };
+        while (events.size() < end) {
+            const std::uint64_t u = r.next();
+            if (live.empty() || (static_cast<int>(live.size()) < cfg.live && u % 3 != 0)) {
+                Live l{ 0, service_size(r) };
+                if (free_slots.empty()) l.slot = next_slot++;
+                else { l.slot = free_slots.back(); free_slots.pop_back(); }
+                emit(l.slot, ReplayOp::Alloc, l.size, 0);
+                emit(l.slot, ReplayOp::Write, 0, l.size);          // constructor fills it
+                live.push_back(l);
+                continue;
+            }
+            const std::size_t i = (u >> 2) % live.size();
+            const Live        l = live[i];
+            if ((u >> 1) & 1) {
+                emit(l.slot, ReplayOp::Free, 0, 0);
+                live[i] = live.back();
+                live.pop_back();
+                free_slots.push_back(l.slot);
+            } else if (r.next() % 1000000 < rate) {
+                // Off-by-a-few mostly; every 20th runs a whole page past the end
+                const std::uint64_t v    = r.next();
+                const std::uint32_t tail = static_cast<std::uint32_t>(std::min<std::uint64_t>(l.size, v % 16));
+                const std::uint32_t over = v % 20 == 0 ? static_cast<std::uint32_t>(4096 + (v >> 8) % 4096)
+                                                       : static_cast<std::uint32_t>(1 + (v >> 8) % 64);
+                emit(l.slot, ReplayOp::Write, l.size - tail, tail + over);
+            } else {
+                const std::uint64_t v   = r.next();
+                const std::uint32_t off = static_cast<std::uint32_t>(v % l.size);
+                emit(l.slot, ReplayOp::Write, off, static_cast<std::uint32_t>(1 + (v >> 32) % (l.size - off)));
+            }
+        }
+        slots = std::max(slots, next_slot);
+        begin.push_back(events.size());
+    }
+
+    ReplayHeader h{};
+    std::memcpy(h.magic, "MCTRACE1", sizeof h.magic);
+    h.shards = static_cast<std::uint32_t>(shards);
+    h.slots  = slots;
+    h.events = events.size();
+
+    std::ofstream out(cfg.file, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(&h), sizeof h);
+    out.write(reinterpret_cast<const char*>(begin.data()),
+              static_cast<std::streamsize>(begin.size() * sizeof(std::uint64_t)));
+    out.write(reinterpret_cast<const char*>(events.data()),
+              static_cast<std::streamsize>(events.size() * sizeof(ReplayEvent)));
+    if (!out) {
+        std::cerr << "[replay] could not write " << cfg.file << '\n';
+        return 1;
+    }
+    std::cout << "[replay] " << events.size() << " events in " << shards << " shards, "
+              << slots << " slots → " << cfg.file << '\n';
+    return 0;
+}
+
+// ------------------------------------------------------------ replay
+
+#if defined(_WIN32)
+
+bool replay_trace(const std::string&, ReplayGuard, int, ReplayResult&)
+{
+    std::cerr << "[replay] trace replay is not available on Windows\n";
+    return false;
+}
+
+int run_replay(const ReplayConfig&)
+{
+    std::cerr << "[replay] trace replay is not available on Windows\n";
+    return 1;
+}
+
+#else
+
+#include "crash_guard.h"
+#include "fault_ring.h"
+#include "stats.h"
+
+#include <atomic>
+#include <csetjmp>
+#include <csignal>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__GLIBC__)
+#  include <malloc.h>
+#endif
+
+namespace {
+
+// Per-thread landing state; the handler only touches these
+thread_local sigjmp_buf            T_JUMP;
+thread_local volatile sig_atomic_t T_ARMED    = 0;   // an overrunning write is in flight
+thread_local volatile std::size_t  T_EVENT    = 0;   // ... and this is its index
+thread_local volatile long long    T_WRITE_NS = 0;
+
+void on_guard_fault(int sig, siginfo_t* info, void*)
+{
+    fault_ring_push(sig, info->si_code, reinterpret_cast<std::uintptr_t>(info->si_addr));
+    if (!T_ARMED) {                 // not ours: let it crash as it would have
+        signal(sig, SIG_DFL);
+        return;
+    }
+    T_ARMED = 0;
+    siglongjmp(T_JUMP, 1);
+}
+
+struct Trace {
+    void*                map      = nullptr;
+    std::size_t          len      = 0;
+    const ReplayHeader*  header   = nullptr;
+    const std::uint64_t* begin    = nullptr;
+    const ReplayEvent*   events   = nullptr;
+};
+
+bool map_trace(const std::string& path, Trace& t)
+{
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) { std::cerr << "[replay] cannot open " << path << '\n'; return false; }
+    struct stat st{};
+    fstat(fd, &st);
+    t.len = static_cast<std::size_t>(st.st_size);
+    if (t.len < sizeof(ReplayHeader)) {
+        close(fd);
+        std::cerr << "[replay] " << path << " is too short for a trace\n";
+        return false;
+    }
+    void* m = mmap(nullptr, t.len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (m == MAP_FAILED) { std::cerr << "[replay] cannot map " << path << '\n'; return false; }
+    madvise(m, t.len, MADV_SEQUENTIAL);
+    t.map = m;
+
+    const auto* bytes = static_cast<const unsigned char*>(m);
+    t.header = reinterpret_cast<const ReplayHeader*>(bytes);
+    const ReplayHeader& h = *t.header;
+    // Sizes are checked by division first: a crafted header must not wrap
+    // the products around to the file length.  Every slot in use takes an
+    // Alloc event, so more slots than events means a bad header, not a
+    // slot table to allocate.
+    const std::size_t table = (static_cast<std::size_t>(h.shards) + 1) * sizeof(std::uint64_t);
+    const std::size_t body  = t.len - sizeof(ReplayHeader);
+    bool ok = std::memcmp(h.magic, "MCTRACE1", sizeof h.magic) == 0 && h.shards > 0
+           && table <= body && h.events <= (body - table) / sizeof(ReplayEvent)
+           && body - table == h.events * sizeof(ReplayEvent) && h.slots <= h.events;
+    if (ok) {
+        t.begin  = reinterpret_cast<const std::uint64_t*>(bytes + sizeof(ReplayHeader));
+        t.events = reinterpret_cast<const ReplayEvent*>(bytes + sizeof(ReplayHeader) + table);
+        ok = t.begin[0] == 0 && t.begin[h.shards] == h.events;
+        for (std::uint32_t s = 0; ok && s < h.shards; ++s) ok = t.begin[s] <= t.begin[s + 1];
+    }
+    if (!ok) {
+        munmap(m, t.len);
+        std::cerr << "[replay] " << path << " is not a valid MCTRACE1 trace\n";
+    }
+    return ok;
+}
+
+struct Block {
+    char*       base = nullptr;   // mapping (or malloc block)
+    char*       user = nullptr;
+    std::size_t size = 0;
+    std::size_t len  = 0;         // bytes reserved for it, guard page included
+};
+
+struct Worker {
+    const Trace* trace  = nullptr;
+    ReplayGuard  guard  = ReplayGuard::Page;
+    std::size_t  page   = 4096;
+    int          index  = 0;
+    int          stride = 1;
+
+    long long              events   = 0;
+    long long              overruns = 0;
+    long long              trapped  = 0;
+    long long              failed   = 0;   // allocations the system refused
+    long long              bad      = 0;   // events on empty or out-of-range slots
+    std::vector<long long> fault_ns;
+    std::size_t            live_req = 0, live_res = 0, peak_req = 0, peak_res = 0;
+};
+
+void release(Worker& w, Block& b)
+{
+    if (!b.base) return;
+    if (w.guard == ReplayGuard::None) std::free(b.base);
+    else                              munmap(b.base, b.len);
+    w.live_req -= b.size;
+    w.live_res -= b.len;
+    b = Block{};
+}
+
+void acquire(Worker& w, Block& b, std::size_t size)
+{
+    release(w, b);                  // an alloc into a live slot replaces it
+    if (w.guard == ReplayGuard::None) {
+        b.base = static_cast<char*>(std::malloc(size ? size : 1));
+        if (!b.base) { ++w.failed; return; }
+#if defined(__GLIBC__)
+        b.len = malloc_usable_size(b.base) + sizeof(std::size_t);
+#else
+        b.len = (size + sizeof(std::size_t) + 15) / 16 * 16;
+#endif
+        b.user = b.base;
+    } else {
+        const std::size_t rounded = std::max<std::size_t>((size + w.page - 1) / w.page * w.page, w.page);
+        void* m = mmap(nullptr, rounded + w.page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (m == MAP_FAILED) { ++w.failed; return; }
+        b.base = static_cast<char*>(m);
+        b.len  = rounded + w.page;
+        if (mprotect(b.base + rounded, w.page, PROT_NONE) != 0) {
+            munmap(m, b.len);
+            b = Block{};
+            ++w.failed;
+            return;
+        }
+        b.user = w.guard == ReplayGuard::Page ? b.base : b.base + ((rounded - size) & ~std::size_t{ 15 });
+    }
+    b.size = size;
+    w.live_req += b.size;
+    w.live_res += b.len;
+    w.peak_req = std::max(w.peak_req, w.live_req);
+    w.peak_res = std::max(w.peak_res, w.live_res);
+}
+
+void replay_span(Worker& w, std::vector<Block>& blocks, std::size_t i, std::size_t end)
+{
+    const ReplayEvent* ev = w.trace->events;
+    for (; i < end; ++i) {
+        const ReplayEvent& e = ev[i];
+        if (e.slot >= blocks.size()) { ++w.bad; continue; }
+        Block& b = blocks[e.slot];
+        if (e.op == ReplayOp::Alloc) { acquire(w, b, e.a); continue; }
+        if (!b.base) { ++w.bad; continue; }
+        if (e.op == ReplayOp::Free) { release(w, b); continue; }
+
+        // A write starting past the end is replayed from the end
+        const std::size_t off = std::min<std::size_t>(e.a, b.size);
+        std::size_t       len = e.b;
+        if (off + len <= b.size) { std::memset(b.user + off, 0xA5, len); continue; }
+
+        ++w.overruns;
+        if (w.guard == ReplayGuard::None) {
+            std::memset(b.user + off, 0xA5, b.size - off);   // the rest would corrupt the heap
+            continue;
+        }
+        // Stop at the end of the guard page: memset may store its tail first
+        len = std::min<std::size_t>(len, static_cast<std::size_t>(b.base + b.len - (b.user + off)));
+        T_EVENT    = i;
+        T_WRITE_NS = guard_clock_ns();
+        std::atomic_signal_fence(std::memory_order_seq_cst);   // counters are in memory if it traps
+        T_ARMED    = 1;
+        std::memset(b.user + off, 0xA5, len);
+        T_ARMED    = 0;
+    }
+}
+
+// Own frame for the sigsetjmp, so nothing of the caller can be clobbered
+void replay_shard(Worker& w, std::size_t lo, std::size_t hi)
+{
+    std::vector<Block> blocks(w.trace->header->slots);
+
+    volatile std::size_t next = lo;
+    if (sigsetjmp(T_JUMP, 1) != 0) {
+        w.fault_ns.push_back(guard_clock_ns() - T_WRITE_NS);
+        ++w.trapped;
+        next = T_EVENT + 1;
+    }
+    replay_span(w, blocks, next, hi);
+
+    for (auto& b : blocks) release(w, b);
+    w.events += static_cast<long long>(hi - lo);
+}
+
+void run_worker(Worker& w)
+{
+    const std::uint32_t shards = w.trace->header->shards;
+    for (auto s = static_cast<std::uint32_t>(w.index); s < shards; s += static_cast<std::uint32_t>(w.stride))
+        replay_shard(w, static_cast<std::size_t>(w.trace->begin[s]), static_cast<std::size_t>(w.trace->begin[s + 1]));
+}
+
+double mib(std::size_t bytes) { return static_cast<double>(bytes) / (1024.0 * 1024.0); }
+
+struct GuardHandlers {
+    struct sigaction old_segv{}, old_bus{};
+
+    GuardHandlers()
+    {
+        struct sigaction sa{};
+        sa.sa_sigaction = on_guard_fault;
+        sa.sa_flags     = SA_SIGINFO;
+        sigemptyset(&sa.sa_mask);
+        sigaction(SIGSEGV, &sa, &old_segv);
+        sigaction(SIGBUS,  &sa, &old_bus);
+    }
+    ~GuardHandlers()
+    {
+        sigaction(SIGSEGV, &old_segv, nullptr);
+        sigaction(SIGBUS,  &old_bus,  nullptr);
+    }
+};
+
+int clamp_threads(int threads, const Trace& trace)
+{
+    const int shards = static_cast<int>(trace.header->shards);
+    return std::clamp(threads > 0 ? threads : shards, 1, shards);
+}
+
+ReplayResult replay_once(const Trace& trace, ReplayGuard g, int threads)
+{
+    std::vector<Worker> workers(static_cast<std::size_t>(threads));
+    for (int t = 0; t < threads; ++t) {
+        Worker& w = workers[static_cast<std::size_t>(t)];
+        w.trace  = &trace;
+        w.guard  = g;
+        w.page   = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+        w.index  = t;
+        w.stride = threads;
+    }
+
+    std::atomic<bool>        go{ false };
+    std::vector<std::thread> pool;
+    for (auto& w : workers)
+        pool.emplace_back([&go, &w] {
+            fault_ring_attach();
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            run_worker(w);
+        });
+    const long long t0 = guard_clock_ns();
+    go.store(true, std::memory_order_release);
+    for (auto& th : pool) th.join();
+
+    ReplayResult r;
+    r.guard   = g;
+    r.threads = threads;
+    r.wall_ns = guard_clock_ns() - t0;
+    std::vector<long long> faults;
+    for (auto& w : workers) {
+        r.events   += w.events;   r.overruns += w.overruns; r.trapped += w.trapped;
+        r.failed   += w.failed;   r.bad      += w.bad;
+        r.peak_req += w.peak_req; r.peak_res += w.peak_res;
+        faults.insert(faults.end(), w.fault_ns.begin(), w.fault_ns.end());
+    }
+    r.fault_p50 = percentile(faults, 50);
+    r.fault_p99 = percentile(faults, 99);
+    return r;
+}
+
+} // namespace
+
+bool replay_trace(const std::string& file, ReplayGuard guard, int threads, ReplayResult& out)
+{
+    Trace trace;
+    if (!map_trace(file, trace)) return false;
+    {
+        GuardHandlers handlers;
+        out = replay_once(trace, guard, clamp_threads(threads, trace));
+    }
+    munmap(trace.map, trace.len);
+    return true;
+}
+
+int run_replay(const ReplayConfig& cfg)
+{
+    Trace trace;
+    if (!map_trace(cfg.file, trace)) return 1;
+    const ReplayHeader& h = *trace.header;
+    const int threads = clamp_threads(cfg.threads, trace);
+
+    std::stringstream out;
+    out << "[replay] " << cfg.file << ": " << h.events << " events in " << h.shards
+        << " shards on " << threads << " thread(s)\n"
+        << "\n| Guard    | Mevents/s | Wall ms | Overruns | Trapped |  Missed | Fault p50 ns | Fault p99 ns "
+        << "| Peak live MiB | Peak reserved MiB |\n"
+        <<   "|----------|----------:|--------:|---------:|--------:|--------:|-------------:|-------------:"
+        << "|--------------:|------------------:|\n";
+    long long failed = 0, bad = 0;
+    {
+        GuardHandlers handlers;
+        for (ReplayGuard g : cfg.guards) {
+            const ReplayResult r = replay_once(trace, g, threads);
+            failed += r.failed;
+            bad    += r.bad;
+            out << "| " << std::left << std::setw(8) << replay_guard_name(g) << std::right << " | "
+                << std::fixed << std::setprecision(2) << std::setw(9) << r.mevents_per_s() << " | "
+                << std::setprecision(1) << std::setw(7) << static_cast<double>(r.wall_ns) / 1e6 << " | "
+                << std::setw(8) << r.overruns << " | " << std::setw(7) << r.trapped << " | "
+                << std::setw(7) << r.overruns - r.trapped << " | "
+                << std::setw(12) << r.fault_p50 << " | " << std::setw(12) << r.fault_p99 << " | "
+                << std::setprecision(2) << std::setw(13) << mib(r.peak_req) << " | "
+                << std::setw(17) << mib(r.peak_res) << " |\n" << std::defaultfloat;
+        }
+    }
+    munmap(trace.map, trace.len);
+
+    out << "\nMissed = overruns that stayed inside the rounding slack (page) or were clamped (none)\n";
+    if (failed) out << "[replay] " << failed << " allocations failed (vm.max_map_count?)\n";
+    if (bad)    out << "[replay] " << bad << " events referred to empty or out-of-range slots\n";
+    std::cout << out.str();
+    return 0;
+}
+
+#endif
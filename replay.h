@@ -0,0 +1,105 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Binary allocation trace, replayed through guarded regions instead of
+ * the synthetic `--alloc`/`--overrun` pair.  Native byte order:
+ *
+ *   ReplayHeader
+ *   std::uint64_t shard_begin[shards + 1]   // event index of each shard, last = events
+ *   ReplayEvent   events[events]            // grouped by shard
+ *
+ * Slots are shard-local, so shards replay independently on any thread.
+ */
+enum class ReplayOp : std::uint8_t {
+    Alloc = 0,   // a = size
+    Write = 1,   // a = offset, b = length; may run past the end of the block
+    Free  = 2,
+};
+
+struct ReplayEvent {
+    std::uint32_t slot;
+    ReplayOp      op;
+    std::uint8_t  pad[3];
+    std::uint32_t a;
+    std::uint32_t b;
+};
+static_assert(sizeof(ReplayEvent) == 16, "ReplayEvent is an on-disk record");
+
+struct ReplayHeader {
+    char          magic[8];   // "MCTRACE1"
+    std::uint32_t shards;
+    std::uint32_t slots;      // slot table size every shard fits in
+    std::uint64_t events;
+    std::uint64_t reserved;
+};
+static_assert(sizeof(ReplayHeader) == 32, "ReplayHeader is an on-disk record");
+
+/** How each allocation of the trace is backed while it replays. */
+enum class ReplayGuard {
+    Page,       // block at the start of its pages, guard page after the rounding slack
+    PageEnd,    // block pushed against the guard page (16-byte aligned), Electric-Fence style
+    None,       // plain malloc; overruns are clamped to the block and counted as missed
+};
+
+const char* replay_guard_name(ReplayGuard g);
+
+/** Parses "page", "page-end" or "none"; false if unknown. */
+bool parse_replay_guard(const std::string& s, ReplayGuard& out);
+
+struct ReplayConfig {
+    std::string              file;
+    std::vector<ReplayGuard> guards  = { ReplayGuard::Page, ReplayGuard::PageEnd, ReplayGuard::None };
+    int                      threads = 0;      // 0 = one per shard
+};
+
+/** One replay of a trace with one guard strategy. */
+struct ReplayResult {
+    ReplayGuard guard     = ReplayGuard::Page;
+    int         threads   = 0;
+    long long   events    = 0;
+    long long   wall_ns   = 0;
+    long long   overruns  = 0;     // writes that ran past their block
+    long long   trapped   = 0;     // ... and hit the guard page
+    long long   failed    = 0;     // allocations the system refused
+    long long   bad       = 0;     // events on empty or out-of-range slots
+    long long   fault_p50 = 0;     // overrunning write → recovered, ns
+    long long   fault_p99 = 0;
+    std::size_t peak_req  = 0;     // per-thread peaks added up: an upper bound
+    std::size_t peak_res  = 0;     // ... of what was reserved for them, guard pages included
+
+    double mevents_per_s() const
+    {
+        return wall_ns > 0 ? static_cast<double>(events) * 1e3 / static_cast<double>(wall_ns) : 0.0;
+    }
+};
+
+/** Replays `file` once; false (and a message on stderr) if it is unusable. */
+bool replay_trace(const std::string& file, ReplayGuard guard, int threads, ReplayResult& out);
+
+/**
+ * Maps `cfg.file` and replays it once per guard strategy, shard by shard
+ * across `threads` workers.  Overrunning writes are timed; a write that
+ * hits a guard page is recovered from via siglongjmp and replay carries
+ * on with the next event.  Prints throughput, fault latency and the
+ * footprint each strategy needed; returns the exit code.
+ */
+int run_replay(const ReplayConfig& cfg);
+
+/** Synthetic trace with a service-like size mix, for trying the replay out. */
+struct ReplayGenConfig {
+    std::string file;
+    long long   events       = 1000000;
+    int         shards       = 4;
+    int         live         = 1000;       // blocks each shard keeps around
+    double      overrun_rate = 0.001;      // fraction of writes that run past the block
+};
+
+/** Writes the trace; returns the exit code. */
+int generate_replay_trace(const ReplayGenConfig& cfg);
+#endif // REPLAY_H
@@ -0,0 +1,224 @@
+#include "shootdown.h"
+
+bool is_shootdown_op(const std::string& s)
+{
+    return s == "mprotect" || s == "munmap" || s == "madvise";
+}
+
+#if defined(_WIN32)
+
+#include <iostream>
+
+int run_shootdown_bench(const ShootdownConfig&)
+{
+    std::cerr << "[shootdown] TLB-shootdown benchmark is not available on Windows\n";
+    return 1;
+}
+
+#else
+
+#include "corunner.h"
+#include "crash_guard.h"
+#include "interference.h"
+#include "stats.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+
+struct alignas(64) Counter {
+    std::atomic<std::uint64_t> n{ 0 };
+};
+
+// N threads on other CPUs that keep the mm busy: each pass touches one
+// byte per page of the shared region (or only spins, when asked to)
+class Workers {
+public:
+    Workers(int n, volatile unsigned char* region, std::size_t pages, std::size_t page,
+            bool spin, const std::vector<int>& cpus)
+        : counters_(static_cast<std::size_t>(n))
+    {
+        for (int i = 0; i < n; ++i) {
+            const int cpu = cpus[static_cast<std::size_t>(i) % cpus.size()];
+            threads_.emplace_back([this, i, cpu, region, pages, page, spin] {
+                if (cpu >= 0) pin_to_cpu(cpu);
+                Counter& c = counters_[static_cast<std::size_t>(i)];
+                while (!stop_.load(std::memory_order_relaxed)) {
+                    if (!spin)
+                        for (std::size_t p = 0; p < pages; ++p) region[p * page] = region[p * page] + 1;
+                    c.n.fetch_add(1, std::memory_order_relaxed);
+                }
+            });
+        }
+    }
+
+    ~Workers()
+    {
+        stop_.store(true);
+        for (auto& t : threads_) t.join();
+    }
+
+    std::uint64_t passes() const
+    {
+        std::uint64_t s = 0;
+        for (auto& c : counters_) s += c.n.load(std::memory_order_relaxed);
+        return s;
+    }
+
+private:
+    std::vector<Counter>     counters_;
+    std::vector<std::thread> threads_;
+    std::atomic<bool>        stop_{ false };
+};
+
+// Sum of the "TLB:" row of /proc/interrupts (x86 only, -1 elsewhere)
+long long tlb_ipis()
+{
+    std::ifstream in("/proc/interrupts");
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream ss(line);
+        std::string tag;
+        if (!(ss >> tag) || tag != "TLB:") continue;
+        long long sum = 0, v = 0;
+        while (ss >> v) sum += v;
+        return sum;
+    }
+    return -1;
+}
+
+// Arms the guard page once and puts it back; returns ns spent arming, or
+// -1 (errno set) if a call failed and the page may no longer be writable.
+// The page is written first so there is a live PTE to invalidate —
+// otherwise the kernel may legitimately skip the flush.
+long long arm_once(const std::string& op, unsigned char* guard, std::size_t page)
+{
+    *reinterpret_cast<volatile unsigned char*>(guard) = 1;
+    long long t0 = 0, t1 = 0;
+    bool ok = false;
+    if (op == "mprotect") {
+        t0 = guard_clock_ns();
+        ok = mprotect(guard, page, PROT_NONE) == 0;
+        t1 = guard_clock_ns();
+        ok = mprotect(guard, page, PROT_READ | PROT_WRITE) == 0 && ok;
+    } else if (op == "munmap") {
+        t0 = guard_clock_ns();
+        ok = munmap(guard, page) == 0;
+        t1 = guard_clock_ns();
+        ok = mmap(guard, page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0)
+             == static_cast<void*>(guard) && ok;
+    } else if (op == "madvise") {
+        t0 = guard_clock_ns();
+        ok = madvise(guard, page, MADV_DONTNEED) == 0;
+        t1 = guard_clock_ns();
+    }
+    return ok ? t1 - t0 : -1;
+}
+
+std::vector<int> default_thread_counts(std::size_t cpus)
+{
+    std::vector<int> v = { 0, 1 };
+    for (std::size_t n = 2; n < cpus; n *= 2) v.push_back(static_cast<int>(n));
+    if (cpus > 2 && static_cast<std::size_t>(v.back()) != cpus) v.push_back(static_cast<int>(cpus));
+    return v;
+}
+
+} // namespace
+
+int run_shootdown_bench(const ShootdownConfig& cfg)
+{
+    const auto page  = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    const auto pages = static_cast<std::size_t>(std::max(1, cfg.region_pages));
+
+    // Worker region followed by the guard page the arming thread churns
+    void* map = mmap(nullptr, (pages + 1) * page, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (map == MAP_FAILED) {
+        std::perror("[shootdown] mmap");
+        return 1;
+    }
+    auto* region = static_cast<unsigned char*>(map);
+    unsigned char* guard = region + pages * page;
+
+    // Without --cpu the arming thread stays where it is; pin it there so
+    // the workers really are on other CPUs and the banner below is true
+    int here = cfg.cpu;
+    if (here < 0) {
+        here = take_interference_snapshot().cpu;
+        if (here >= 0 && !pin_to_cpu(here)) here = -1;
+    }
+
+    const std::vector<int> cpus = default_load_cpus(here);
+    const std::vector<int> counts = cfg.threads.empty()
+                                  ? default_thread_counts(cpus.front() < 0 ? 1 : cpus.size())
+                                  : cfg.threads;
+
+    std::cout << "[shootdown] " << cfg.iters << " arms per op, " << pages << " shared pages, workers "
+              << (cfg.spin ? "spin" : "touch") << " on " << (cpus.front() < 0 ? 0 : cpus.size())
+              << " other CPU(s)\n";
+
+    std::stringstream out;
+    out << "\n| Threads | Op       | Arm p50 (ns) | Arm p99 (ns) | TLB IPIs/arm | Worker slowdown |\n"
+        <<   "|--------:|----------|-------------:|-------------:|-------------:|----------------:|\n";
+
+    for (int n : counts) {
+        Workers w(n, region, pages, page, cfg.spin, cpus);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));   // let them spread out
+
+        for (const auto& op : cfg.ops) {
+            std::vector<long long> lat;
+            lat.reserve(static_cast<std::size_t>(cfg.iters));
+
+            const long long     ipi0 = tlb_ipis();
+            const std::uint64_t c0   = w.passes();
+            const long long     t0   = guard_clock_ns();
+            for (int i = 0; i < cfg.iters; ++i) {
+                const long long ns = arm_once(op, guard, page);
+                if (ns < 0) {
+                    std::perror(("[shootdown] " + op).c_str());
+                    return 1;                    // workers stop with `w`; the mapping goes at exit
+                }
+                lat.push_back(ns);
+            }
+            const long long     t1   = guard_clock_ns();
+            const std::uint64_t c1   = w.passes();
+            const long long     ipi1 = tlb_ipis();
+
+            // Same-length window without arming: what the workers do undisturbed
+            std::this_thread::sleep_for(std::chrono::nanoseconds(t1 - t0));
+            const long long     t2 = guard_clock_ns();
+            const std::uint64_t c2 = w.passes();
+
+            out << "| " << std::setw(7) << n << " | " << std::left << std::setw(8) << op << std::right
+                << " | " << std::setw(12) << percentile(lat, 50) << " | " << std::setw(12)
+                << percentile(lat, 99) << " | " << std::fixed << std::setprecision(2);
+            if (ipi0 >= 0 && ipi1 >= ipi0) out << std::setw(12) << static_cast<double>(ipi1 - ipi0) / cfg.iters;
+            else                           out << std::setw(12) << "-";
+            out << " | ";
+            const double armed = static_cast<double>(c1 - c0) / static_cast<double>(t1 - t0);
+            const double idle  = static_cast<double>(c2 - c1) / static_cast<double>(t2 - t1);
+            if (n > 0 && idle > 0) out << std::setw(14) << (1.0 - armed / idle) * 100 << "%";
+            else                   out << std::setw(15) << "-";
+            out << " |\n" << std::defaultfloat;
+        }
+    }
+    munmap(map, (pages + 1) * page);
+
+    out << "\nWorker slowdown = drop in worker passes/s while arming vs. an unarmed window\n";
+    std::cout << out.str();
+    return 0;
+}
+
+#endif
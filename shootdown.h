@@ -0,0 +1,33 @@
+#ifndef SHOOTDOWN_H
+#define SHOOTDOWN_H
+
+#include <string>
+#include <vector>
+
+/**
+ * TLB-shootdown benchmark.  Arming a guard page (`mprotect`, `munmap`,
+ * `madvise(MADV_DONTNEED)`) has to invalidate stale TLB entries on every
+ * CPU currently running the same mm, so its cost grows with the number of
+ * busy threads — and those threads eat an IPI each time.
+ *
+ * For each thread count N, N workers pinned to other CPUs touch (or just
+ * spin next to) a shared region while the calling thread arms and disarms
+ * a guard page `iters` times per operation.  Reported: arming latency and
+ * how much the workers' own throughput drops compared with an unarmed
+ * window of the same length.
+ */
+struct ShootdownConfig {
+    std::vector<int>         threads;           // empty = 0, 1, 2, 4 … CPUs-1
+    std::vector<std::string> ops = { "mprotect", "munmap", "madvise" };
+    int                      iters       = 2000;
+    int                      region_pages = 64;    // pages the workers touch
+    bool                     spin        = false;  // workers spin instead of touching
+    int                      cpu         = -1;     // CPU of the arming thread
+};
+
+/** True for "mprotect", "munmap" and "madvise", the operations the sweep knows. */
+bool is_shootdown_op(const std::string& s);
+
+/** Runs the sweep, prints a table; returns the process exit code. */
+int run_shootdown_bench(const ShootdownConfig& cfg);
+#endif // SHOOTDOWN_H
@@ -0,0 +1,252 @@
+#include "stack_guard.h"
+
+#if defined(_WIN32)
+
+#include <iostream>
+
+int run_stack_guard_bench(const StackGuardConfig&)
+{
+    std::cerr << "[stack] thread-stack guard benchmark is not available on Windows\n";
+    return 1;
+}
+
+#else
+
+#include "crash_guard.h"
+#include "fault_ring.h"
+#include "stats.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <csetjmp>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <pthread.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr std::size_t ALT_STACK = 64 * 1024;
+
+// Per-thread landing state; the handler only touches these
+thread_local sigjmp_buf             T_JUMP;
+thread_local volatile std::uintptr_t T_ADDR       = 0;
+thread_local volatile long long      T_HANDLER_NS = 0;
+thread_local volatile long long      T_START_NS   = 0;
+
+volatile long long DEPTH_LIMIT = 1LL << 40;   // never reached; keeps the recursion finite to the compiler
+
+void on_stack_overflow(int sig, siginfo_t* info, void*)
+{
+    T_HANDLER_NS = guard_clock_ns();
+    T_ADDR       = reinterpret_cast<std::uintptr_t>(info->si_addr);
+    fault_ring_push(sig, info->si_code, T_ADDR);
+    siglongjmp(T_JUMP, 1);
+}
+
+// Each frame writes both ends of its pad so every stack page gets touched
+long long recurse(long long depth)
+{
+    volatile char pad[512];
+    pad[0]   = static_cast<char>(depth);
+    pad[511] = static_cast<char>(depth);
+    if (depth >= DEPTH_LIMIT) return depth;
+    return recurse(depth + 1) + pad[0];
+}
+
+struct Overflow {
+    bool      faulted  = false;
+    bool      in_guard = false;    // si_addr inside the guard below the stack
+    long long total_ns = 0;        // recursion start → back on the normal stack
+    long long resume_ns = 0;       // handler entry → back on the normal stack
+};
+
+struct OverflowArg {
+    std::size_t guard = 0;
+    Overflow    result;
+};
+
+void* overflow_thread(void* p)
+{
+    auto* arg = static_cast<OverflowArg*>(p);
+    fault_ring_attach();
+
+    std::vector<char> alt(ALT_STACK);
+    stack_t ss{};
+    ss.ss_sp    = alt.data();
+    ss.ss_size  = alt.size();
+    sigaltstack(&ss, nullptr);
+
+    // Lowest usable stack address; glibc puts the guard right below it
+    std::uintptr_t lo = 0;
+    pthread_attr_t self;
+    if (pthread_getattr_np(pthread_self(), &self) == 0) {
+        void* addr = nullptr; std::size_t size = 0;
+        pthread_attr_getstack(&self, &addr, &size);
+        lo = reinterpret_cast<std::uintptr_t>(addr);
+        pthread_attr_destroy(&self);
+    }
+
+    if (sigsetjmp(T_JUMP, 1) == 0) {
+        T_START_NS = guard_clock_ns();
+        recurse(0);
+    } else {
+        const long long now = guard_clock_ns();
+        arg->result.faulted   = true;
+        arg->result.total_ns  = now - T_START_NS;
+        arg->result.resume_ns = now - T_HANDLER_NS;
+        arg->result.in_guard  = T_ADDR < lo && T_ADDR + arg->guard >= lo;
+    }
+
+    ss.ss_flags = SS_DISABLE;
+    sigaltstack(&ss, nullptr);
+    return nullptr;
+}
+
+bool make_attr(pthread_attr_t& attr, std::size_t stack, std::size_t guard)
+{
+    pthread_attr_init(&attr);
+    if (pthread_attr_setstacksize(&attr, stack) != 0 || pthread_attr_setguardsize(&attr, guard) != 0) {
+        pthread_attr_destroy(&attr);
+        return false;
+    }
+    return true;
+}
+
+std::size_t count_mappings()
+{
+    std::ifstream in("/proc/self/maps");
+    std::size_t n = 0;
+    for (std::string line; std::getline(in, line);) ++n;
+    return n;
+}
+
+// Virtual size in KiB; guards are address space, not resident memory
+double vsz_kib()
+{
+    std::ifstream in("/proc/self/statm");
+    double pages = 0;
+    in >> pages;
+    return pages * static_cast<double>(sysconf(_SC_PAGESIZE)) / 1024.0;
+}
+
+std::string human(std::size_t bytes)
+{
+    if (bytes >= (1u << 20) && bytes % (1u << 20) == 0) return std::to_string(bytes >> 20) + " MiB";
+    if (bytes >= (1u << 10) && bytes % (1u << 10) == 0) return std::to_string(bytes >> 10) + " KiB";
+    return std::to_string(bytes) + " B";
+}
+
+// Threads that stay alive until told to go, so `count` of them coexist
+struct Gate {
+    std::mutex              m;
+    std::condition_variable cv;
+    bool                    open = false;
+};
+
+void* parked_thread(void* p)
+{
+    auto* g = static_cast<Gate*>(p);
+    std::unique_lock<std::mutex> lock(g->m);
+    g->cv.wait(lock, [g] { return g->open; });
+    return nullptr;
+}
+
+} // namespace
+
+int run_stack_guard_bench(const StackGuardConfig& cfg)
+{
+    struct sigaction sa{}, old_segv{}, old_bus{};
+    sa.sa_sigaction = on_stack_overflow;
+    sa.sa_flags     = SA_SIGINFO | SA_ONSTACK;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGSEGV, &sa, &old_segv);
+    sigaction(SIGBUS,  &sa, &old_bus);
+
+    std::stringstream out;
+    out << "\n| Guard    | Stack    | Trials | In guard | Overflow p50 (ns) | Handler→resume p50 (ns) |\n"
+        <<   "|----------|----------|-------:|---------:|------------------:|------------------------:|\n";
+    for (std::size_t guard : cfg.guards) {
+        pthread_attr_t attr;
+        if (!make_attr(attr, cfg.stack_size, guard)) {
+            std::cerr << "[stack] invalid stack " << cfg.stack_size << " / guard " << guard << '\n';
+            continue;
+        }
+        std::vector<long long> total, resume;
+        int in_guard = 0;
+        for (int t = 0; t < cfg.trials; ++t) {
+            OverflowArg arg{ guard, {} };
+            pthread_t th;
+            if (pthread_create(&th, &attr, overflow_thread, &arg) != 0) break;
+            pthread_join(th, nullptr);
+            if (!arg.result.faulted) continue;
+            total.push_back(arg.result.total_ns);
+            resume.push_back(arg.result.resume_ns);
+            in_guard += arg.result.in_guard;
+        }
+        pthread_attr_destroy(&attr);
+        out << "| " << std::left << std::setw(8) << human(guard) << " | " << std::setw(8)
+            << human(cfg.stack_size) << std::right << " | " << std::setw(6) << total.size() << " | "
+            << std::setw(8) << in_guard << " | " << std::setw(17) << percentile(total, 50) << " | "
+            << std::setw(23) << percentile(resume, 50) << " |\n";
+    }
+
+    sigaction(SIGSEGV, &old_segv, nullptr);
+    sigaction(SIGBUS,  &old_bus,  nullptr);
+
+    out << "\n| Guard    | Threads | Created | µs/thread | Threads/s | Mappings/thread | VSZ KiB/thread |\n"
+        <<   "|----------|--------:|--------:|----------:|----------:|----------------:|---------------:|\n";
+    for (std::size_t guard : cfg.guards) {
+        for (int count : cfg.spawn) {
+            pthread_attr_t attr;
+            if (!make_attr(attr, cfg.stack_size, guard)) continue;
+
+            Gate gate;
+            std::vector<pthread_t> threads;
+            threads.reserve(static_cast<std::size_t>(std::max(count, 0)));
+            const std::size_t maps0 = count_mappings();
+            const double      vsz0  = vsz_kib();
+            const long long   t0    = guard_clock_ns();
+            for (int i = 0; i < count; ++i) {
+                pthread_t th;
+                if (pthread_create(&th, &attr, parked_thread, &gate) != 0) break;
+                threads.push_back(th);
+            }
+            const long long   t1    = guard_clock_ns();
+            const std::size_t maps1 = count_mappings();
+            const double      vsz1  = vsz_kib();
+            {
+                std::lock_guard<std::mutex> lock(gate.m);
+                gate.open = true;
+            }
+            gate.cv.notify_all();
+            for (auto th : threads) pthread_join(th, nullptr);
+            pthread_attr_destroy(&attr);
+
+            const double n  = static_cast<double>(threads.size());
+            const double us = n > 0 ? static_cast<double>(t1 - t0) / 1000.0 / n : 0.0;
+            out << "| " << std::left << std::setw(8) << human(guard) << std::right << " | "
+                << std::setw(7) << count << " | " << std::setw(7) << threads.size() << " | "
+                << std::fixed << std::setprecision(2) << std::setw(9) << us << " | "
+                << std::setprecision(0) << std::setw(9) << (us > 0 ? 1e6 / us : 0.0) << " | "
+                << std::setprecision(2) << std::setw(15)
+                << (n > 0 ? (static_cast<double>(maps1) - static_cast<double>(maps0)) / n : 0.0)
+                << " | " << std::setprecision(0) << std::setw(14) << (n > 0 ? (vsz1 - vsz0) / n : 0.0)
+                << " |\n" << std::defaultfloat;
+        }
+    }
+    out << "\nglibc caches freed thread stacks, so later rows may reuse earlier mappings\n";
+    std::cout << out.str();
+    return 0;
+}
+
+#endif
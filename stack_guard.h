@@ -0,0 +1,27 @@
+#ifndef STACK_GUARD_H
+#define STACK_GUARD_H
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * Thread-stack guard benchmark.  A stack overflow faults on the guard
+ * page below the stack, and since the faulting stack is exhausted the
+ * handler can only run on an alternate stack (`sigaltstack`).
+ *
+ * For each guard size a thread with a `stack_size` stack recurses into
+ * its guard `trials` times and recovers via siglongjmp from a handler on
+ * its alternate stack.  Then `spawn` threads per count are created and
+ * kept alive together to measure creation throughput and the mappings
+ * each guard adds.
+ */
+struct StackGuardConfig {
+    std::vector<std::size_t> guards     = { 4096, 64 * 1024, 1024 * 1024 };
+    std::size_t              stack_size = 256 * 1024;
+    std::vector<int>         spawn      = { 100, 1000 };
+    int                      trials     = 20;
+};
+
+/** Runs both sweeps and prints their tables; returns the exit code. */
+int run_stack_guard_bench(const StackGuardConfig& cfg);
+#endif // STACK_GUARD_H
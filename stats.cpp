@@ -0,0 +1,143 @@
+#include "stats.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+long long percentile(std::vector<long long> samples, double p)
+{
+    if (samples.empty())
+        return 0;
+
+    const double rank = std::ceil(p / 100.0 * static_cast<double>(samples.size()));
+    std::size_t  idx  = rank < 1 ? 0 : static_cast<std::size_t>(rank) - 1;
+    idx = std::min(idx, samples.size() - 1);
+
+    std::nth_element(samples.begin(), samples.begin() + idx, samples.end());
+    return samples[idx];
+}
+
+double mean(const std::vector<long long>& samples)
+{
+    if (samples.empty())
+        return 0.0;
+    double sum = 0.0;
+    for (long long x : samples) sum += static_cast<double>(x);
+    return sum / static_cast<double>(samples.size());
+}
+
+double stddev(const std::vector<long long>& samples)
+{
+    if (samples.size() < 2)
+        return 0.0;
+    const double m = mean(samples);
+    double ss = 0.0;
+    for (long long x : samples) {
+        const double d = static_cast<double>(x) - m;
+        ss += d * d;
+    }
+    return std::sqrt(ss / static_cast<double>(samples.size() - 1));
+}
+
+namespace {
+
+// 0.975 Student t quantiles (two-sided 95 %) for 1..30 degrees of freedom
+double t_975(std::size_t df)
+{
+    static const double table[] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+         2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+         2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042 };
+    if (df == 0)  return std::numeric_limits<double>::infinity();
+    if (df <= 30) return table[df - 1];
+    return 1.96;
+}
+
+} // namespace
+
+double mean_ci_half_width(const std::vector<long long>& samples)
+{
+    if (samples.size() < 2)
+        return std::numeric_limits<double>::infinity();
+    const double n = static_cast<double>(samples.size());
+    return t_975(samples.size() - 1) * stddev(samples) / std::sqrt(n);
+}
+
+double median_ci_half_width(std::vector<long long> samples)
+{
+    const std::size_t n = samples.size();
+    if (n < 6)   // too few points for the rank interval to exist
+        return std::numeric_limits<double>::infinity();
+
+    const double half = 0.98 * std::sqrt(static_cast<double>(n));
+    const auto   lo   = static_cast<std::size_t>(std::max(0.0, std::floor(n / 2.0 - half)));
+    const auto   hi   = std::min(n - 1, static_cast<std::size_t>(std::ceil(n / 2.0 + half)));
+
+    std::sort(samples.begin(), samples.end());
+    return (static_cast<double>(samples[hi]) - static_cast<double>(samples[lo])) / 2.0;
+}
+
+LinearFit fit_linear(const std::vector<double>& x, const std::vector<double>& y)
+{
+    LinearFit f;
+    f.n = std::min(x.size(), y.size());
+    if (f.n < 2)
+        return f;
+
+    double mx = 0, my = 0;
+    for (std::size_t i = 0; i < f.n; ++i) { mx += x[i]; my += y[i]; }
+    mx /= static_cast<double>(f.n);
+    my /= static_cast<double>(f.n);
+
+    double sxx = 0, sxy = 0, syy = 0;
+    for (std::size_t i = 0; i < f.n; ++i) {
+        const double dx = x[i] - mx, dy = y[i] - my;
+        sxx += dx * dx; sxy += dx * dy; syy += dy * dy;
+    }
+    if (sxx == 0)
+        return f;
+
+    f.slope     = sxy / sxx;
+    f.intercept = my - f.slope * mx;
+    f.r2        = syy == 0 ? 1.0 : (sxy * sxy) / (sxx * syy);
+    return f;
+}
+
+MannWhitney mann_whitney(const std::vector<long long>& a, const std::vector<long long>& b)
+{
+    MannWhitney m;
+    const std::size_t na = a.size(), nb = b.size(), n = na + nb;
+    if (na == 0 || nb == 0)
+        return m;
+
+    // (value, from b?) sorted; tied runs share their average rank
+    std::vector<std::pair<long long, bool>> all;
+    all.reserve(n);
+    for (long long x : a) all.emplace_back(x, false);
+    for (long long x : b) all.emplace_back(x, true);
+    std::sort(all.begin(), all.end());
+
+    double rank_b = 0.0, ties = 0.0;
+    for (std::size_t i = 0; i < n;) {
+        std::size_t j = i;
+        while (j < n && all[j].first == all[i].first) ++j;
+        const double t   = static_cast<double>(j - i);
+        const double avg = (static_cast<double>(i + 1) + static_cast<double>(j)) / 2.0;
+        for (std::size_t k = i; k < j; ++k)
+            if (all[k].second) rank_b += avg;
+        ties += t * t * t - t;
+        i = j;
+    }
+
+    const double fa = static_cast<double>(na), fb = static_cast<double>(nb), fn = static_cast<double>(n);
+    m.u = rank_b - fb * (fb + 1) / 2.0;
+    const double mu    = fa * fb / 2.0;
+    const double sigma = std::sqrt(fa * fb / 12.0 * ((fn + 1) - ties / (fn * (fn - 1))));
+    if (sigma == 0)
+        return m;
+
+    m.z         = (m.u - mu) / sigma;
+    m.p_greater = 0.5 * std::erfc(m.z / std::sqrt(2.0));
+    m.p_two     = std::min(1.0, std::erfc(std::fabs(m.z) / std::sqrt(2.0)));
+    return m;
+}
@@ -0,0 +1,56 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * Nearest-rank percentile of `samples` (p in [0, 100]).
+ * Takes the vector by value because it has to be partially sorted.
+ * Returns 0 for an empty sample.
+ */
+long long percentile(std::vector<long long> samples, double p);
+
+/** Arithmetic mean, 0 for an empty sample. */
+double mean(const std::vector<long long>& samples);
+
+/** Sample standard deviation (n - 1), 0 for fewer than two samples. */
+double stddev(const std::vector<long long>& samples);
+
+/**
+ * Half-width of the 95 % confidence interval of the mean (Student t).
+ * Infinite for fewer than two samples.
+ */
+double mean_ci_half_width(const std::vector<long long>& samples);
+
+/**
+ * Distribution-free 95 % confidence half-width of the median, taken from
+ * the order statistics n/2 ± 0.98·√n.  Heavy fault-latency tails make
+ * this far more stable than the mean-based interval.
+ */
+double median_ci_half_width(std::vector<long long> samples);
+/** Ordinary least-squares fit y = intercept + slope·x. */
+struct LinearFit {
+    double intercept = 0.0;
+    double slope     = 0.0;
+    double r2        = 0.0;     // coefficient of determination
+    std::size_t n    = 0;
+};
+
+/** Fits a line through (x[i], y[i]); all zero if x has no spread. */
+LinearFit fit_linear(const std::vector<double>& x, const std::vector<double>& y);
+
+/** Mann-Whitney U test of sample `b` against sample `a`. */
+struct MannWhitney {
+    double u         = 0.0;     // U statistic of `b`
+    double z         = 0.0;     // normal approximation, tie-corrected
+    double p_greater = 1.0;     // one-sided: `b` tends to be larger than `a`
+    double p_two     = 1.0;     // two-sided
+};
+
+/**
+ * Rank-sum test via the normal approximation; fine for the sample sizes
+ * a latency comparison works with (both sides ≥ ~20).
+ */
+MannWhitney mann_whitney(const std::vector<long long>& a, const std::vector<long long>& b);
+#endif // STATS_H
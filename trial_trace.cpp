@@ -0,0 +1,177 @@
+#include "trial_trace.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#if defined(_WIN32)
+#  include <process.h>
+#  define getpid _getpid
+#else
+#  include <unistd.h>
+#endif
+
+namespace {
+
+struct Event {
+    std::uint64_t ns;
+    const char*   test;       // only set on Trial records
+    std::uint32_t trial;
+    TracePhase    phase;
+    bool          end;
+};
+
+struct Buffer {
+    std::vector<Event> ev;        // sized once, never grows while recording
+    std::size_t        n       = 0;
+    std::uint64_t      dropped = 0;
+    TracePhase         open[16]{};
+    int                depth   = 0;
+    const char*        test    = nullptr;
+    std::uint32_t      trial   = 0;
+    std::uint32_t      tid     = 0;
+};
+
+std::mutex                           g_mutex;
+std::vector<std::unique_ptr<Buffer>> g_buffers;
+std::size_t                          g_capacity = 0;
+thread_local Buffer*                 t_buf      = nullptr;
+
+const char* phase_name(TracePhase p)
+{
+    switch (p) {
+        case TracePhase::Trial:     return "trial";
+        case TracePhase::Mmap:      return "mmap";
+        case TracePhase::Mprotect:  return "mprotect";
+        case TracePhase::Memset:    return "memset";
+        case TracePhase::Overrun:   return "overrun";
+        case TracePhase::TrapEntry: return "trap entry";
+        case TracePhase::Handler:   return "handler";
+        case TracePhase::Recovery:  return "recovery";
+        case TracePhase::Cleanup:   return "cleanup";
+    }
+    return "?";
+}
+
+std::uint64_t now_ns()
+{
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// Registers this thread's buffer on first use (normal context only)
+Buffer* thread_buffer()
+{
+    if (!t_buf) {
+        auto b = std::make_unique<Buffer>();
+        b->ev.resize(g_capacity);
+        std::lock_guard<std::mutex> lock(g_mutex);
+        b->tid = static_cast<std::uint32_t>(g_buffers.size() + 1);
+        t_buf  = b.get();
+        g_buffers.push_back(std::move(b));
+    }
+    return t_buf;
+}
+
+void push(Buffer& b, std::uint64_t ns, TracePhase p, bool end)
+{
+    if (b.n == b.ev.size()) { ++b.dropped; return; }
+    b.ev[b.n++] = Event{ ns, p == TracePhase::Trial ? b.test : nullptr, b.trial, p, end };
+}
+
+// Closes open phases down to and including `p`, all at time `ns`
+void close_to(Buffer& b, std::uint64_t ns, TracePhase p)
+{
+    for (int d = b.depth - 1; d >= 0; --d) {
+        if (b.open[d] != p) continue;
+        while (b.depth > d) push(b, ns, b.open[--b.depth], true);
+        return;
+    }
+}
+
+} // namespace
+
+namespace trace_detail {
+
+bool enabled = false;
+
+void record(TracePhase p, bool end, const char* test, std::uint32_t trial)
+{
+    const std::uint64_t ns = now_ns();
+
+    // Only opening a trial may register the buffer; everything else can
+    // run inside the signal handler and must not allocate
+    Buffer* bp = (p == TracePhase::Trial && !end) ? thread_buffer() : t_buf;
+    if (!bp) return;
+    Buffer& b = *bp;
+    if (end) {
+        close_to(b, ns, p);
+        return;
+    }
+    if (p == TracePhase::Trial) { b.test = test; b.trial = trial; }
+    if (b.depth == static_cast<int>(sizeof(b.open) / sizeof(b.open[0]))) { ++b.dropped; return; }
+    b.open[b.depth++] = p;
+    push(b, ns, p, false);
+}
+
+void fault()
+{
+    const std::uint64_t ns = now_ns();
+    Buffer* b = t_buf;                      // never allocate in the handler
+    if (!b) return;
+    while (b->depth > 0 && b->open[b->depth - 1] != TracePhase::Trial)
+        push(*b, ns, b->open[--b->depth], true);
+    if (b->depth < static_cast<int>(sizeof(b->open) / sizeof(b->open[0]))) {
+        b->open[b->depth++] = TracePhase::Handler;
+        push(*b, ns, TracePhase::Handler, false);
+    }
+}
+
+} // namespace trace_detail
+
+void trace_enable(std::size_t events_per_thread)
+{
+    g_capacity = events_per_thread;
+    trace_detail::enabled = true;
+    thread_buffer();                         // main thread: allocate up front
+}
+
+bool write_trace_json(const std::string& path)
+{
+    std::FILE* f = std::fopen(path.c_str(), "w");
+    if (!f) return false;
+
+    const long pid = static_cast<long>(getpid());
+    std::uint64_t t0 = ~std::uint64_t(0), dropped = 0;
+
+    std::lock_guard<std::mutex> lock(g_mutex);
+    for (auto& b : g_buffers)
+        if (b->n) t0 = std::min(t0, b->ev[0].ns);
+
+    std::fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n", f);
+    bool first = true;
+    for (auto& b : g_buffers) {
+        dropped += b->dropped;
+        std::fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%ld,\"tid\":%u,"
+                        "\"args\":{\"name\":\"trials-%u\"}}",
+                     first ? "" : ",\n", pid, b->tid, b->tid);
+        first = false;
+        for (std::size_t i = 0; i < b->n; ++i) {
+            const Event& e = b->ev[i];
+            const double us = static_cast<double>(e.ns - t0) / 1000.0;
+            if (e.phase == TracePhase::Trial && !e.end)
+                std::fprintf(f, ",\n{\"name\":\"%s #%u\",\"cat\":\"trial\",\"ph\":\"B\",\"ts\":%.3f,"
+                                "\"pid\":%ld,\"tid\":%u,\"args\":{\"trial\":%u}}",
+                             e.test ? e.test : "trial", e.trial, us, pid, b->tid, e.trial);
+            else
+                std::fprintf(f, ",\n{\"name\":\"%s\",\"cat\":\"phase\",\"ph\":\"%c\",\"ts\":%.3f,"
+                                "\"pid\":%ld,\"tid\":%u}",
+                             phase_name(e.phase), e.end ? 'E' : 'B', us, pid, b->tid);
+        }
+    }
+    std::fprintf(f, "\n],\"otherData\":{\"dropped_events\":%llu}}\n",
+                 static_cast<unsigned long long>(dropped));
+    return std::fclose(f) == 0;
+}
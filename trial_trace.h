@@ -0,0 +1,63 @@
+#ifndef TRIAL_TRACE_H
+#define TRIAL_TRACE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * Phase timeline of every trial, exported as Chrome / Perfetto
+ * trace-event JSON (open it in ui.perfetto.dev or chrome://tracing).
+ *
+ * Each thread appends fixed-size begin/end records to its own
+ * preallocated buffer; recording is a timestamp plus a store, takes no
+ * locks and never allocates, so the SIGSEGV handler may call it too.
+ * When tracing is off every call is a single branch.
+ */
+enum class TracePhase : std::uint8_t {
+    Trial, Mmap, Mprotect, Memset, Overrun, TrapEntry, Handler, Recovery, Cleanup
+};
+
+namespace trace_detail {
+extern bool enabled;
+void record(TracePhase p, bool end, const char* test, std::uint32_t trial);
+void fault();
+} // namespace trace_detail
+
+/** Turns recording on; each thread keeps up to `events_per_thread` records. */
+void trace_enable(std::size_t events_per_thread = std::size_t(1) << 20);
+
+inline void trace_begin(TracePhase p)
+{
+    if (trace_detail::enabled) trace_detail::record(p, false, nullptr, 0);
+}
+
+inline void trace_end(TracePhase p)
+{
+    if (trace_detail::enabled) trace_detail::record(p, true, nullptr, 0);
+}
+
+/** Opens the per-trial span the other phases nest in. */
+inline void trace_begin_trial(const char* test, std::uint32_t trial)
+{
+    if (trace_detail::enabled) trace_detail::record(TracePhase::Trial, false, test, trial);
+}
+
+inline void trace_end_trial()
+{
+    if (trace_detail::enabled) trace_detail::record(TracePhase::Trial, true, nullptr, 0);
+}
+
+/**
+ * Called on fault entry: closes whatever phases the faulting code left
+ * open (they ended when the CPU trapped) and opens `Handler`.
+ * Async-signal-safe.
+ */
+inline void trace_fault()
+{
+    if (trace_detail::enabled) trace_detail::fault();
+}
+
+/** Writes all threads' records as trace-event JSON; false on I/O error. */
+bool write_trace_json(const std::string& path);
+#endif // TRIAL_TRACE_H